@@ -4,7 +4,6 @@
 
 #include "ApplicationInfo.h"
 #include "Future.h"
-#include "Singleton.h"
 
 #include "Storage.h"
 #include "OnlineListener.h"
@@ -16,15 +15,32 @@
 
 #include "curl_multi.h"
 
+#include <atomic>
 #include <set>
 #include <unordered_map>
 
 namespace online
 {
 	typedef std::shared_ptr< class AnthillRuntime > AnthillRuntimePtr;
-
-	class AnthillRuntime : public Singleton<AnthillRuntime>
+	typedef std::shared_ptr< class WebsocketHub > WebsocketHubPtr;
+	typedef std::shared_ptr< class TokenManager > TokenManagerPtr;
+	typedef std::shared_ptr< class ScoreQueue > ScoreQueuePtr;
+
+	// Everything a runtime has (the futures, the transport, the websocket hub, the services) is its own,
+	// so any number of runtimes can live in one process, each driven by one thread at a time.
+	//
+	// The services reach their runtime through AnthillRuntime::Instance(), which is the runtime bound to
+	// the calling thread: a new runtime is bound to the thread that has created it, update() binds the
+	// runtime for its duration (so every callback sees the right one), and AnthillRuntime::Scope binds
+	// one for a block, e.g. to call the services of several runtimes driven by the same thread.
+	// A thread with no runtime bound (or with one that has been destroyed since) has no Instance():
+	// IsInstanceValid() is false there, and Instance() logs and aborts.
+	class AnthillRuntime
 	{
+	public:
+		// called for every completed request, with the time it took in seconds
+		typedef std::function<void (const Request& request, float duration)> RequestObserver;
+
 	private:
 		typedef std::function<ServicePtr (const std::string&)> ServiceCreator;
 
@@ -38,6 +54,27 @@ namespace online
 		}
 
 	public:
+		// binds a runtime to the current thread for the lifetime of the object
+		class Scope
+		{
+		public:
+			Scope(AnthillRuntime& runtime);
+			~Scope();
+
+		private:
+			Scope(const Scope&) = delete;
+			void operator=(const Scope&) = delete;
+
+			AnthillRuntime* m_previous;
+			std::shared_ptr<const std::atomic<bool>> m_previousAlive;
+		};
+
+	public:
+		// the runtime bound to the current thread
+		static AnthillRuntime& Instance();
+		static AnthillRuntime* InstancePtr();
+		static bool IsInstanceValid();
+
 		static AnthillRuntimePtr Create(
 			const std::string& environment,
 			const std::set<std::string>& enabledServices, 
@@ -47,6 +84,9 @@ namespace online
 
 		virtual ~AnthillRuntime();
 
+		// binds the runtime to the current thread, until some other one is
+		void bind();
+
 		// updates the online lib, should be called every frame
 		void update(float dt);
 
@@ -58,6 +98,17 @@ namespace online
 		const StoragePtr& getStorage() const;
         const ListenerPtr& getListener() const;
 
+		// the event loop every websocket session of this runtime runs on
+		const WebsocketHubPtr& getWebsocketHub() const;
+		// makes the runtime share a loop with others, whoever owns the loop updates it
+		// should be set before any session is created
+		void setWebsocketHub(const WebsocketHubPtr& hub);
+
+		// keeps the access token of the LoginService fresh
+		const TokenManagerPtr& getTokenManager() const;
+		// sends the scores posted to the leaderboards and the events in batches
+		const ScoreQueuePtr& getScoreQueue() const;
+
 		ServicePtr SetService(const std::string& id, const std::string& location);
 
 		template <class T>
@@ -82,6 +133,9 @@ namespace online
 		// adds a request to a process loop
 		void addRequest(RequestPtr request);
 
+		void setRequestObserver(RequestObserver observer) { m_requestObserver = observer; }
+		void requestCompleted(const Request& request, float duration);
+
 		const std::function< void(std::string&,std::string&) >& getGenerateGuestUserCredentialsFunction() const { return m_generateGuestUserCredentialsFunction; }
 		void setGenerateGuestUserCredentialsFunction( const std::function< void(std::string&,std::string&) >& function ){ m_generateGuestUserCredentialsFunction = function; }
 		
@@ -102,8 +156,19 @@ namespace online
 			const ApplicationInfo& applicationInfo);
 
 	private:
+		AnthillRuntime(const AnthillRuntime&) = delete;
+		void operator=(const AnthillRuntime&) = delete;
+
+	private:
+		// cleared once the runtime is destroyed, for the threads it's still bound to
+		std::shared_ptr<std::atomic<bool>> m_alive;
+
 		curl::curl_multi m_transport;
 		std::unordered_map<curl::curl_easy*, RequestPtr> m_requests;
+		WebsocketHubPtr m_websocketHub;
+		bool m_ownsWebsocketHub;
+		TokenManagerPtr m_tokenManager;
+		ScoreQueuePtr m_scoreQueue;
 		ApplicationInfo m_applicationInfo;
 		Futures m_futures;
 		StoragePtr m_storage;
@@ -115,6 +180,7 @@ namespace online
 
 		std::function< void(std::string&,std::string&) > m_generateGuestUserCredentialsFunction;
 		std::function< void( int code, const std::string& str ) > m_onSocketDisconnectedInfo;
+		RequestObserver m_requestObserver;
 	};
 };
 
@@ -0,0 +1,162 @@
+
+#ifndef ONLINE_BundleManager_H
+#define ONLINE_BundleManager_H
+
+#include "services/DLCService.h"
+
+#include <json/value.h>
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace online
+{
+	typedef std::shared_ptr< class BundleManager > BundleManagerPtr;
+	typedef std::shared_ptr< class BundleDownloadRequest > BundleDownloadRequestPtr;
+
+	// Keeps the bundles from DLCService::getUpdates installed in a directory.
+	//
+	// The bundles that are missing (or have another hash than the installed ones) are downloaded
+	// a few at a time into '<name>.part', with the SHA-256 and CRC32 computed as the data comes in,
+	// so nothing is read back once the download is over. A bundle that matches is moved over
+	// '<name>' in one rename and only then recorded as installed, so a crash or a failed download
+	// never leaves a broken bundle in place.
+	//
+	//     online::BundleManagerPtr bundles = online::BundleManager::Create(directory);
+	//
+	//     dlc->getUpdates(m_bundles, [=](const online::DLCService&, online::Request::Result result, const online::Request&)
+	//     {
+	//         bundles->update(m_bundles,
+	//             [](const online::BundleManager::Progress& progress) { ... },
+	//             [](bool success, const std::set<std::string>& failed) { ... });
+	//     });
+	//
+	// The directory should exist already.
+	class BundleManager : public std::enable_shared_from_this<BundleManager>
+	{
+	public:
+		struct Policy
+		{
+			Policy() :
+				maxDownloads(4),
+				maxBytesInFlight(64 * 1024 * 1024),
+				retries(2),
+				stallTimeout(30)
+			{}
+
+			// bundles downloaded at the same time
+			size_t maxDownloads;
+			// the sizes of the bundles being downloaded add up to no more than that,
+			// unless it's a single bundle larger than it
+			long maxBytesInFlight;
+			// times a failed bundle is downloaded again
+			int retries;
+			// seconds a download may receive nothing before it fails
+			long stallTimeout;
+		};
+
+		struct Progress
+		{
+			Progress() :
+				downloaded(0),
+				total(0),
+				bundles(0),
+				installed(0)
+			{}
+
+			// bytes, over all of the bundles being updated
+			long downloaded;
+			long total;
+
+			size_t bundles;
+			size_t installed;
+		};
+
+		typedef std::function< void(const Progress& progress) > ProgressCallback;
+		// 'failed' are the bundles that could not be installed
+		typedef std::function< void(bool success, const std::set<std::string>& failed) > UpdateCallback;
+
+	public:
+		static BundleManagerPtr Create(const std::string& directory);
+		virtual ~BundleManager();
+
+		void setPolicy(const Policy& policy) { m_policy = policy; }
+		const Policy& getPolicy() const { return m_policy; }
+
+		const std::string& getDirectory() const { return m_directory; }
+		std::string getPath(const std::string& name) const;
+
+		bool isInstalled(const DLCService::Bundle& bundle) const;
+		// the bundles that are not installed, or are of another version
+		DLCService::Bundles getMissing(const DLCService::Bundles& bundles) const;
+
+		// downloads and installs whatever is missing of the bundles
+		void update(const DLCService::Bundles& bundles, ProgressCallback onProgress, UpdateCallback onUpdated);
+		// stops the update and removes the partial downloads, the callbacks are not called
+		void cancel();
+
+		bool isUpdating() const { return m_updating; }
+		const Progress& getProgress() const { return m_progress; }
+
+	protected:
+		BundleManager(const std::string& directory);
+		bool init();
+
+	private:
+		struct Download
+		{
+			Download(const DLCService::Bundle& bundle) :
+				bundle(bundle),
+				attempt(0)
+			{}
+
+			DLCService::Bundle bundle;
+			BundleDownloadRequestPtr request;
+			int attempt;
+		};
+
+		typedef std::list<Download> Downloads;
+
+		void next();
+		bool start(Download& download);
+		void downloaded(const BundleDownloadRequest& request);
+		bool verify(const Download& download) const;
+		bool install(const Download& download);
+		void failed(Download& download);
+
+		void postProgress();
+		void reportProgress();
+		// on the next update, once nothing is left to download
+		void postFinish();
+		void finish();
+
+		void load();
+		void save();
+
+	private:
+		std::string m_directory;
+		Policy m_policy;
+
+		// name: {"hash", "crc32", "size"} of the installed bundles
+		Json::Value m_installed;
+
+		Downloads m_queue;
+		Downloads m_active;
+		std::set<std::string> m_failed;
+
+		Progress m_progress;
+		// bytes of the bundles installed during this update
+		long m_completed;
+		bool m_progressPosted;
+		bool m_updating;
+
+		ProgressCallback m_onProgress;
+		UpdateCallback m_onUpdated;
+	};
+};
+
+#endif
@@ -0,0 +1,233 @@
+
+#ifndef ONLINE_Coroutines_H
+#define ONLINE_Coroutines_H
+
+// An awaitable layer over the callback based services.
+// It is only available when compiled as C++20 with coroutine support, the rest
+// of the runtime does not depend on it.
+//
+//     online::Task flow(online::ProfileServicePtr profiles, std::string token)
+//     {
+//         auto response = co_await online::awaitCallback<online::ProfileService::GetProfileCallback>(
+//             [&](online::ProfileService::GetProfileCallback done) { profiles->getMyProfile("", token, done); });
+//
+//         if (std::get<1>(response) == online::Request::SUCCESS) ...
+//
+//         online::CallResult call = co_await online::awaitCall(
+//             [&](online::JsonRPC::Success success, online::JsonRPC::Failture failture)
+//             { session->call("hello", args, success, failture, 5.0f); });
+//     }
+//
+// Every callback of the runtime is delivered on the thread calling AnthillRuntime::update,
+// so that is where the coroutines resume. Results passed by reference (a service, a request)
+// stay valid until the next co_await, the same as inside the callback itself.
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ANTHILL_COROUTINES 1
+#endif
+#endif
+
+#ifdef ANTHILL_COROUTINES
+
+#include "anthill/Future.h"
+#include "anthill/JsonRPC.h"
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <tuple>
+
+namespace online
+{
+    // A detached coroutine: starts right away and frees itself once it's done.
+    struct Task
+    {
+        struct promise_type
+        {
+            Task get_return_object() { return Task(); }
+            std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+            std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    template <typename Start, typename Callback>
+    class CallbackAwaiter;
+
+    // Suspends until the callback handed to 'start' is called, and returns its arguments as a tuple.
+    // The awaiter lives in the coroutine frame and the callback only captures a pointer to it,
+    // so an await does not allocate on its own.
+    //
+    // A callback called before 'start' has returned only records the result: the coroutine is not
+    // resumed from inside 'start' (it could finish and free the frame 'start' is running from),
+    // await_suspend returns false instead and the coroutine goes on once 'start' is done.
+    template <typename Start, typename... Args>
+    class CallbackAwaiter<Start, std::function<void(Args...)> >
+    {
+    public:
+        typedef std::tuple<Args...> Result;
+
+        CallbackAwaiter(Start start) :
+            m_start(std::move(start)),
+            m_starting(false)
+        {}
+
+        bool await_ready() const { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            m_starting = true;
+
+            m_start(std::function<void(Args...)>([this](Args... args)
+            {
+                m_result.emplace(args...);
+
+                if (!m_starting)
+                {
+                    m_handle.resume();
+                }
+            }));
+
+            m_starting = false;
+
+            // completed already, so the coroutine is not suspended at all
+            return !m_result;
+        }
+
+        Result await_resume()
+        {
+            return std::move(*m_result);
+        }
+
+    private:
+        Start m_start;
+        std::coroutine_handle<> m_handle;
+        bool m_starting;
+        std::optional<Result> m_result;
+    };
+
+    template <typename Callback, typename Start>
+    CallbackAwaiter<Start, Callback> awaitCallback(Start start)
+    {
+        return CallbackAwaiter<Start, Callback>(std::move(start));
+    }
+
+    // The outcome of a JSON-RPC call (or any success/failture callback pair)
+    struct CallResult
+    {
+        CallResult() :
+            success(false),
+            code(0)
+        {}
+
+        bool success;
+        Json::Value result;
+        int code;
+        std::string message;
+        std::string data;
+    };
+
+    template <typename Start>
+    class CallAwaiter
+    {
+    public:
+        CallAwaiter(Start start) :
+            m_start(std::move(start)),
+            m_starting(false),
+            m_completed(false)
+        {}
+
+        bool await_ready() const { return false; }
+
+        // same as CallbackAwaiter, an inline completion does not resume from inside 'start'
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            m_starting = true;
+
+            m_start(JsonRPC::Success([this](const Json::Value& response)
+            {
+                m_result.success = true;
+                m_result.result = response;
+                complete();
+            }), JsonRPC::Failture([this](int code, const std::string& message, const std::string& data)
+            {
+                m_result.code = code;
+                m_result.message = message;
+                m_result.data = data;
+                complete();
+            }));
+
+            m_starting = false;
+            return !m_completed;
+        }
+
+        CallResult await_resume()
+        {
+            return std::move(m_result);
+        }
+
+    private:
+        void complete()
+        {
+            m_completed = true;
+
+            if (!m_starting)
+            {
+                m_handle.resume();
+            }
+        }
+
+    private:
+        Start m_start;
+        std::coroutine_handle<> m_handle;
+        bool m_starting;
+        bool m_completed;
+        CallResult m_result;
+    };
+
+    template <typename Start>
+    CallAwaiter<Start> awaitCall(Start start)
+    {
+        return CallAwaiter<Start>(std::move(start));
+    }
+
+    // Suspends for the given amount of seconds
+    class DelayAwaiter
+    {
+    public:
+        DelayAwaiter(Futures& futures, float time) :
+            m_futures(futures),
+            m_time(time)
+        {}
+
+        bool await_ready() const { return m_time <= 0; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            // the future is never due within add(), and Futures calls a one-shot callback on a copy
+            // it owns, so the frame (and this awaiter) may go away while it runs
+            m_futures.add(m_time, [handle]() { handle.resume(); });
+        }
+
+        void await_resume() {}
+
+    private:
+        Futures& m_futures;
+        float m_time;
+    };
+
+    inline DelayAwaiter delay(Futures& futures, float time)
+    {
+        return DelayAwaiter(futures, time);
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+
+#ifndef ONLINE_Deadlines_H
+#define ONLINE_Deadlines_H
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace online
+{
+	// When something identified by 'id' (a timer, a pending request) is due
+	struct Deadline
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		Deadline(Clock::time_point when, int id) :
+			m_when(when),
+			m_id(id)
+		{}
+
+		bool operator > (const Deadline& other) const
+		{
+			return m_when > other.m_when;
+		}
+
+		Clock::time_point m_when;
+		int m_id;
+	};
+
+	// The deadlines ordered so the earliest one is on top.
+	// Nothing is removed from the middle: an id that is gone stays in the heap until it comes up,
+	// and is skipped then. compact() drops those once they outnumber the live ones.
+	class Deadlines
+	{
+	public:
+		bool empty() const { return m_heap.empty(); }
+		size_t size() const { return m_heap.size(); }
+		const Deadline& top() const { return m_heap.front(); }
+
+		void push(const Deadline& deadline)
+		{
+			m_heap.push_back(deadline);
+			std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Deadline>());
+		}
+
+		void emplace(Deadline::Clock::time_point when, int id)
+		{
+			push(Deadline(when, id));
+		}
+
+		void pop()
+		{
+			std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Deadline>());
+			m_heap.pop_back();
+		}
+
+		void clear() { m_heap.clear(); }
+
+		// 'live' is how many ids there are at most, 'isLive' tells if an id is still there
+		template <class IsLive>
+		void compact(size_t live, IsLive isLive)
+		{
+			if (m_heap.size() <= live * 2)
+				return;
+
+			m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [&isLive](const Deadline& deadline)
+			{
+				return !isLive(deadline.m_id);
+			}), m_heap.end());
+
+			std::make_heap(m_heap.begin(), m_heap.end(), std::greater<Deadline>());
+		}
+
+	private:
+		std::vector<Deadline> m_heap;
+	};
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef ONLINE_EventCache_H
+#define ONLINE_EventCache_H
+
+#include "services/EventService.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace online
+{
+	typedef std::shared_ptr< class EventCache > EventCachePtr;
+
+	// The events, fetched once and then again only when one of them starts or ends
+	// (or when told so, e.g. by a push), instead of polling. A failed fetch is tried again a bit later.
+	// The time left and the state of the events are counted locally from the time of the server
+	// when they were fetched.
+	class EventCache : public std::enable_shared_from_this<EventCache>
+	{
+	public:
+		typedef std::function< void(const EventCache& cache, Request::Result result) > Callback;
+		typedef std::function< void(const EventCache& cache) > ChangedCallback;
+
+	public:
+		static EventCachePtr Create(const EventServicePtr& service, const std::string& accessToken,
+			int extraStartTime = 0, int extraEndTime = 0);
+		virtual ~EventCache();
+
+		void setAccessToken(const std::string& accessToken) { m_accessToken = accessToken; }
+
+		// fetches the events unless they are there already, the callback is called right away if they are
+		void sync(Callback callback);
+		// fetches them again right away, e.g. once a push about the events has come
+		void refresh(Callback callback = nullptr);
+
+		bool isSynced() const { return m_synced; }
+		const EventService::Events& getEvents() const { return m_events; }
+		// null if there's no such event
+		EventPtr getEvent(const std::string& id) const;
+
+		// called every time the events are fetched again
+		void setOnChanged(ChangedCallback callback) { m_onChanged = callback; }
+
+	protected:
+		EventCache(const EventServicePtr& service, const std::string& accessToken, int extraStartTime, int extraEndTime);
+		bool init();
+
+	private:
+		void fetched(Request::Result result, EventService::Events& events);
+		void scheduleRefresh();
+		void scheduleRetry();
+
+	private:
+		std::weak_ptr<EventService> m_service;
+		std::string m_accessToken;
+		int m_extraStartTime;
+		int m_extraEndTime;
+
+		EventService::Events m_events;
+		bool m_synced;
+		bool m_fetching;
+		std::vector<Callback> m_callbacks;
+
+		// the future of the next refresh (or of the retry of a failed one), 0 if none
+		int m_refreshFuture;
+		// seconds, 0 unless the last fetch has failed
+		float m_retryInterval;
+		ChangedCallback m_onChanged;
+	};
+};
+
+#endif
@@ -0,0 +1,99 @@
+
+#ifndef ONLINE_FileStorage_H
+#define ONLINE_FileStorage_H
+
+#include "Storage.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+namespace online
+{
+	typedef std::shared_ptr< class FileStorage > FileStoragePtr;
+
+	// A Storage kept in a file, that never blocks the caller on disk.
+	//
+	// The values live in memory. The changes made between the save() calls are coalesced
+	// into a single batch, and a background thread appends the batches to a journal next to
+	// the file ('<path>.journal'), one line per batch. Once the journal grows long enough,
+	// it is compacted: the whole state is written into '<path>.tmp', moved over the file,
+	// and the journal is truncated.
+	//
+	// A crash of the process at any point leaves either the previous or the new state on disk:
+	// a batch torn half way through is ignored on load (and compacted away before anything is
+	// appended after it), and a journal that has already been compacted just applies over the
+	// file again. Nothing is fsync'ed, so that does not hold for a power loss or an OS crash.
+	class FileStorage : public Storage
+	{
+	public:
+		static FileStoragePtr Create(const std::string& path, int compactAfter = 64);
+		virtual ~FileStorage();
+
+		virtual void set(const std::string& key, const std::string& value) override;
+		virtual std::string get(const std::string& key) const override;
+		virtual bool has(const std::string& key) const override;
+		virtual void remove(const std::string& key) override;
+		virtual void save() override;
+
+		// saves and blocks until everything is written
+		void flush();
+
+	protected:
+		FileStorage(const std::string& path, int compactAfter);
+		bool init();
+
+	private:
+		typedef std::unordered_map<std::string, std::string> Values;
+
+		struct Batch
+		{
+			Values m_set;
+			std::set<std::string> m_remove;
+
+			bool empty() const { return m_set.empty() && m_remove.empty(); }
+			void set(const std::string& key, const std::string& value);
+			void remove(const std::string& key);
+			void merge(const Batch& other);
+			void apply(Values& values) const;
+		};
+
+		void load();
+		void run();
+		bool write(const Batch& batch);
+		bool compact();
+
+	private:
+		std::string m_path;
+		int m_compactAfter;
+
+		// accessed by the caller only
+		Values m_values;
+		Batch m_pending;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wakeUp;
+		std::condition_variable m_written;
+		std::list<Batch> m_queue;
+		unsigned int m_queued;
+		unsigned int m_done;
+		bool m_stopping;
+		std::atomic<bool> m_failed;
+
+		// accessed by the background thread only
+		Values m_persisted;
+		std::ofstream m_journal;
+		int m_journalRecords;
+		// the journal ends with a record that has not been written out in full
+		bool m_journalTorn;
+
+		std::thread m_thread;
+	};
+};
+
+#endif
@@ -2,10 +2,21 @@
 #ifndef ONLINE_Future_H
 #define ONLINE_Future_H
 
+#include "anthill/Deadlines.h"
+
 #include <assert.h>
+#include <chrono>
 #include <functional>
-#include <list>
 #include <unordered_map>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define ONLINE_DEPRECATED(Msg) __attribute__((deprecated(Msg)))
+#elif defined(_MSC_VER)
+#	define ONLINE_DEPRECATED(Msg) __declspec(deprecated(Msg))
+#else
+#	define ONLINE_DEPRECATED(Msg)
+#endif
 
 namespace online
 {
@@ -14,42 +25,59 @@ namespace online
 	public:
         static const int REPEAT_FOREVER;
 		typedef std::function<void(void)> Callback;
+        typedef std::chrono::steady_clock Clock;
 
 	public:
 		Future(float time, Callback callback, int repeat = 0);
 
-        void cancel();
-		bool update(float dt);
-	private:
-        float m_time;
-        float m_original;
+        Clock::duration m_period;
 		Callback m_callback;
-        bool m_cancelled;
         int m_repeat;
-
 	};
 
+	// Timers ordered by their deadline on a monotonic clock.
+	// An update only touches the timers that are due, and repeating ones are
+	// rescheduled from their previous deadline, so they do not drift.
 	class Futures
 	{
 	public:
 
         Futures() :
+            m_updating(false),
             m_nextId(1)
         {}
-        
+
 		~Futures()
 		{}
 
         void cancel(int futureId);
+
+        // calls the callback in 'time' seconds, and then 'repeat' more times with the same interval
+        // (or forever with Future::REPEAT_FOREVER)
 		int add(float time, Future::Callback callback, int repeat = 0);
 		void postNextUpdate(Future::Callback callback);
 
-		void update(float dt);
+		void update();
+
+		// the timers run on the steady clock, 'dt' is ignored: a game that pauses or scales its time
+		// has to cancel and add its timers again itself
+		ONLINE_DEPRECATED("Futures run on the steady clock, use update()")
+		void update(float dt) { (void)dt; update(); }
         void clear();
-        
+
+        // seconds until the earliest future is due (0 if one is due already), or a negative value if there are none
+        float getTimeToNext();
+
+	private:
+        void dropCancelled();
+
 	private:
 		std::unordered_map<int, Future> m_futures;
-		std::list<Future::Callback> m_nextUpdate;
+        Deadlines m_deadlines;
+        // deadlines scheduled while the update is running, so they are not fired within the same update
+        std::vector<Deadline> m_scheduled;
+		std::vector<Future::Callback> m_nextUpdate;
+        bool m_updating;
         int m_nextId;
 	};
 };
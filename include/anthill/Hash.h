@@ -0,0 +1,60 @@
+
+#ifndef ONLINE_Hash_H
+#define ONLINE_Hash_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace online
+{
+	// Checksums computed piece by piece, as the data comes in
+	//
+	//     online::SHA256 sha256;
+	//     sha256.update(chunk, size);
+	//     ...
+	//     std::string digest = sha256.hex();
+
+	class SHA256
+	{
+	public:
+		SHA256();
+
+		void update(const void* data, size_t size);
+		void reset();
+
+		// lowercase hex digest of everything so far, the hash can not be updated after that
+		std::string hex();
+
+	private:
+		void transform(const uint8_t* block);
+		void finish();
+
+	private:
+		uint32_t m_state[8];
+		uint8_t m_block[64];
+		size_t m_blockSize;
+		uint64_t m_length;
+		bool m_finished;
+	};
+
+	class CRC32
+	{
+	public:
+		CRC32() :
+			m_crc(0xFFFFFFFFu)
+		{}
+
+		void update(const void* data, size_t size);
+		void reset() { m_crc = 0xFFFFFFFFu; }
+
+		uint32_t get() const { return ~m_crc; }
+		// lowercase, 8 digits
+		std::string hex() const;
+
+	private:
+		uint32_t m_crc;
+	};
+};
+
+#endif
@@ -3,8 +3,13 @@
 #define _JsonRPC_h_
 
 #include "json/value.h"
+#include "anthill/Deadlines.h"
+
 #include <unordered_map>
 #include <functional>
+#include <chrono>
+#include <set>
+#include <vector>
 
 namespace online
 {
@@ -16,17 +21,22 @@ namespace online
         
         typedef std::function < void (const Json::Value& params, Success success, Failture failture) > RequestHandler;
         
+        typedef std::chrono::steady_clock Clock;
+        
         struct ResponseHandler
         {
-            ResponseHandler(Success& success, Failture& failture, int future) :
+            ResponseHandler(Success& success, Failture& failture, float timeout) :
                 m_success(success),
                 m_failture(failture),
-                m_future(future)
+                m_timeout(timeout)
             {}
         
             Success m_success;
             Failture m_failture;
-            int m_future;
+            float m_timeout;
+            
+            // the serialized request, kept only for methods that are safe to send again
+            std::string m_replay;
         };
         
         typedef std::unordered_map< std::string, RequestHandler > RequestHandlers;
@@ -37,14 +47,28 @@ namespace online
 		virtual ~JsonRPC();
         
         void handle(const std::string& method, RequestHandler handler);
+        
+        // marks a method as idempotent, so pending calls to it are sent again after a reconnect
+        // instead of being rejected
+        void setIdempotent(const std::string& method);
         void request(const std::string& method, Success success, Failture failture, const Json::Value& params, float timeout = 0);
         void rpc(const std::string& method, const Json::Value& params);
+        
+        // collects the following request/rpc calls into a single batch frame,
+        // sent on flush or at the end of the next update
+        void beginBatch();
+        void flush();
+        
         virtual void update();
         
     private:
         Json::Value serializeError(int code, const std::string& message, const std::string& data = "");
         void writeError(int code, const std::string& message, const std::string& data = "", int id = -1);
         void writeResponse(const Json::Value result, int id);
+        void send(const Json::Value& message);
+        void reply(const Json::Value& message);
+        void process(const Json::Value& msg);
+        void checkTimeouts();
 
 	protected:
         JsonRPC();
@@ -53,13 +77,25 @@ namespace online
         virtual bool read(std::string& data) = 0;
         virtual void write(const std::string& data) = 0;
         virtual void error(int code, const std::string& message, const std::string& data) = 0;
+        // false while what's written is dropped, e.g. until a socket is connected again
+        virtual bool isWritable() const { return true; }
         
         void received(const std::string& message);
         void rejectAllResponseHandlers(int code, const std::string& message, const std::string& data);
+        void rejectNonReplayableResponseHandlers(int code, const std::string& message, const std::string& data);
+        void replayResponseHandlers();
         
     private:
         RequestHandlers m_handlers;
         ResponseHandlers m_responseHandlers;
+        Deadlines m_deadlines;
+        std::set<std::string> m_idempotentMethods;
+        
+        bool m_batching;
+        Json::Value m_batch;
+        // replies to a batch received from the other side, sent back as one frame
+        Json::Value* m_replies;
+        
         int m_nextId;
 	};
 
@@ -0,0 +1,121 @@
+#ifndef ONLINE_LeaderboardWindow_H
+#define ONLINE_LeaderboardWindow_H
+
+#include "services/LeaderboardService.h"
+
+#include <json/value.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace online
+{
+	typedef std::shared_ptr< class LeaderboardWindow > LeaderboardWindowPtr;
+
+	// A local copy of the parts of a leaderboard that have been looked at, fetched page by page.
+	// The entries are kept in one vector by their position (rank - 1), and the names and the accounts
+	// are interned, so scrolling back and forth does not fetch or allocate anything again.
+	class LeaderboardWindow : public std::enable_shared_from_this<LeaderboardWindow>
+	{
+	public:
+		typedef uint32_t StringId;
+
+		struct Row
+		{
+			Row() :
+				rank(0),
+				score(0),
+				displayName(0),
+				account(0),
+				loaded(false)
+			{}
+
+			int rank;
+			float score;
+			StringId displayName;
+			StringId account;
+			bool loaded;
+		};
+
+		typedef std::function< void(const LeaderboardWindow& window, Request::Result result) > Callback;
+
+	public:
+		static LeaderboardWindowPtr Create(const LeaderboardServicePtr& service, const std::string& name,
+			const std::string& order, const std::string& accessToken, int pageSize = 50);
+		virtual ~LeaderboardWindow();
+
+		// fetches the pages of the positions [offset, offset + count) that are not there yet,
+		// the callback is called right away if there's nothing to fetch
+		void ensure(size_t offset, size_t count, Callback callback);
+		// fetches 'count' entries around the one of the player, see findAccount
+		void loadAroundMe(int count, Callback callback);
+
+		// the positions up to the last one fetched, some of them may be not loaded yet
+		size_t size() const { return m_rows.size(); }
+		// true once a page has come short, so the total is known
+		bool isEndKnown() const { return m_end != NO_END; }
+		bool isLoaded(size_t position) const { return position < m_rows.size() && m_rows[position].loaded; }
+		// null if the position is not fetched yet
+		const Row* get(size_t position) const { return isLoaded(position) ? &m_rows[position] : nullptr; }
+		// null if the entry had no profile
+		const Json::Value* getProfile(size_t position) const;
+
+		const std::string& getString(StringId id) const { return m_strings[id]; }
+		const std::string& getDisplayName(const Row& row) const { return m_strings[row.displayName]; }
+		const std::string& getAccount(const Row& row) const { return m_strings[row.account]; }
+
+		// the position of the entry of the account, -1 if it's not loaded
+		int findAccount(const std::string& account) const;
+
+		// a score has changed locally (e.g. the player has posted a new one), the entry moves to its new place
+		// among the loaded ones, and the ranks of the entries it has passed are updated
+		void updateScore(const std::string& account, float score);
+
+		// drops everything, the next ensure fetches it again; the requests in flight
+		// are answered with CLIENT_ERROR and what they bring is thrown away
+		void clear();
+
+	protected:
+		LeaderboardWindow(const LeaderboardServicePtr& service, const std::string& name,
+			const std::string& order, const std::string& accessToken, int pageSize);
+		bool init();
+
+	private:
+		typedef std::function< void(Request::Result result) > PageCallback;
+		typedef std::shared_ptr< std::vector<PageCallback> > PageCallbacks;
+		static const size_t NO_END;
+
+		StringId intern(const std::string& value);
+		void fetch(size_t page, PageCallback callback);
+		void merge(size_t first, const Json::Value& data);
+		void move(size_t from, size_t to);
+		bool before(float a, float b) const;
+
+	private:
+		std::weak_ptr<LeaderboardService> m_service;
+		std::string m_name;
+		std::string m_order;
+		std::string m_accessToken;
+		int m_pageSize;
+
+		std::vector<Row> m_rows;
+		// by position, only of the entries with a profile
+		std::unordered_map<size_t, Json::Value> m_profiles;
+
+		std::vector<std::string> m_strings;
+		std::unordered_map<std::string, StringId> m_stringIds;
+		std::unordered_map<StringId, size_t> m_positions;
+
+		// the callbacks of the pages being fetched, by their first position
+		std::unordered_map<size_t, PageCallbacks> m_fetching;
+		size_t m_end;
+		// bumped by clear, the responses to the requests made before that are dropped
+		uint32_t m_generation;
+	};
+};
+
+#endif
@@ -1,4 +1,3 @@
-
 #ifndef ONLINE_Log_H
 #define ONLINE_Log_H
 
@@ -7,58 +6,75 @@
 #include <ctime>
 #include <iomanip>
 #include <functional>
+#include <memory>
+#include <string>
+
+// Lines below that level are compiled out when logged with OnlineLog (0 debug, 1 info, 2 warning, 3 error)
+#ifndef ONLINE_LOG_LEVEL
+#define ONLINE_LOG_LEVEL 1
+#endif
+
+// OnlineLog(LEVEL_DEBUG) << "Response: " << value.toStyledString() << std::endl;
+// The arguments are not even evaluated below ONLINE_LOG_LEVEL.
+#define OnlineLog(level) \
+	if (online::Log::level < ONLINE_LOG_LEVEL) {} else online::Log::get(online::Log::level)
 
 namespace online
 {
-	class Log {
-	private:
-		std::ostringstream oss;
-		std::function<void(const std::string&)> callback;
-	public:
+	class LogRing;
 
-		static Log& get()
+	// Each thread formats its lines into a buffer of its own, and std::endl hands the line over
+	// to a lock-free ring of that thread. A background sink drains the rings, adds the timestamps
+	// and writes the lines out, so the calling thread never waits on the output itself
+	// (the formatting still happens on the calling thread).
+	// If a ring is full, the line is dropped (and counted) rather than blocking.
+	class Log
+	{
+	public:
+		typedef enum Level
 		{
-			static Log instance;
-			return instance;
-		}
+			LEVEL_DEBUG = 0,
+			LEVEL_INFO = 1,
+			LEVEL_WARNING = 2,
+			LEVEL_ERROR = 3
+		} Level_;
 
-		void overrideLog(std::function<void(const std::string&)> _callback)
-		{
-			this->callback = _callback;
-		}
+		typedef std::function<void(const std::string&)> Callback;
 
-		template <typename T>
-		Log& operator<<(T a)
-		{
-			oss << a;
-			return *this;
-		}
+	public:
+		static Log& get(Level level = LEVEL_INFO);
 
-		Log& operator<<(std::ostream&(*f)(std::ostream&))
+		// the lines below that level are skipped at runtime (their arguments are still evaluated)
+		static void setLevel(Level level);
+		// blocks until every line logged so far is written
+		static void flush();
+
+		// The callback is called instead of writing into std::cout, by default on the thread that has
+		// logged the line, right away. With 'onSinkThread' it's called on the background sink thread
+		// instead, so it must not touch anything that is not thread safe (e.g. the game or the UI).
+		void overrideLog(Callback callback, bool onSinkThread = false);
+
+		template <typename T>
+		Log& operator<<(const T& a)
 		{
-            std::ostream& (*pEndl)(std::ostream &) = &(std::endl);
-            
-			if (f == pEndl)
+			if (m_enabled)
 			{
-				if (callback)
-				{
-					callback(oss.str());
-				}
-				else
-				{
-					time_t t = std::time(nullptr);
-                    char foo[32];
-                    
-					if(0 < strftime(foo, sizeof(foo), "[%T%z %F] ", std::localtime(&t)))
-                    {
-                        std::cout << "[ *********** ONLINE *********** ] " << foo << " " << oss.str() << std::endl;
-                    }
-				}
-
-				oss.str("");
+				m_oss << a;
 			}
+
 			return *this;
 		}
+
+		Log& operator<<(std::ostream&(*f)(std::ostream&));
+
+		Log();
+		~Log();
+
+	private:
+		std::ostringstream m_oss;
+		Level m_level;
+		bool m_enabled;
+		std::shared_ptr<LogRing> m_ring;
 	};
 };
 
@@ -0,0 +1,95 @@
+
+#ifndef ONLINE_Pipeline_H
+#define ONLINE_Pipeline_H
+
+#include "Tracing.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace online
+{
+	typedef std::shared_ptr< class Pipeline > PipelinePtr;
+
+	// A set of named stages with dependencies between them.
+	// Every stage starts as soon as all of its dependencies have succeeded, so the
+	// independent ones run concurrently. A failed stage fails the whole pipeline.
+	class Pipeline : public std::enable_shared_from_this<Pipeline>
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		typedef std::function< void(bool success) > StageDone;
+		typedef std::function< void(StageDone done) > StageFunction;
+
+		struct StageTiming
+		{
+			std::string name;
+			// seconds since the pipeline has been started
+			float started;
+			float duration;
+			bool success;
+		};
+
+		typedef std::vector<StageTiming> Timings;
+		typedef std::function< void(bool success, const Timings& timings) > CompleteCallback;
+
+	public:
+		static PipelinePtr Create(const std::string& name);
+		virtual ~Pipeline();
+
+		void addStage(const std::string& name, const std::set<std::string>& dependencies, StageFunction function);
+		bool hasStage(const std::string& name) const;
+
+		void start(CompleteCallback callback);
+
+		bool isRunning() const { return m_running; }
+		const std::string& getName() const { return m_name; }
+
+		// timings of the stages finished so far, in the order they have finished
+		const Timings& getTimings() const { return m_timings; }
+
+	protected:
+		Pipeline(const std::string& name);
+
+	private:
+		enum StageStatus
+		{
+			STAGE_PENDING,
+			STAGE_RUNNING,
+			STAGE_SUCCEEDED,
+			STAGE_FAILED
+		};
+
+		struct Stage
+		{
+			std::string name;
+			std::set<std::string> dependencies;
+			StageFunction function;
+			StageStatus status;
+			Clock::time_point started;
+			Tracer::SpanId span;
+		};
+
+		void schedule();
+		void finished(size_t index, bool success);
+		float since(Clock::time_point time) const;
+
+	private:
+		std::string m_name;
+		std::vector<Stage> m_stages;
+		Timings m_timings;
+		CompleteCallback m_callback;
+		Clock::time_point m_started;
+		bool m_running;
+		bool m_failed;
+		bool m_scheduling;
+		bool m_rescheduled;
+	};
+};
+
+#endif
@@ -0,0 +1,376 @@
+#ifndef ONLINE_ProfileBinding_H
+#define ONLINE_ProfileBinding_H
+
+#include "services/ProfileService.h"
+#include "Log.h"
+#include "Utils.h"
+
+#include <json/value.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binds a plain struct to a profile, field by field, with no read/write to write by hand.
+// The struct lists its fields once:
+//
+//     struct PlayerProfile
+//     {
+//         int level = 1;
+//         std::string name;
+//         std::vector<std::string> unlocks;
+//         Stats stats; // another struct with a describe() of its own
+//
+//         static void describe(online::ProfileFields<PlayerProfile>& fields)
+//         {
+//             fields
+//                 .add("level", &PlayerProfile::level)
+//                 .add("name", &PlayerProfile::name)
+//                 .add("unlocks", &PlayerProfile::unlocks)
+//                 .add("stats", &PlayerProfile::stats);
+//         }
+//     };
+//
+//     PlayerProfile player;
+//     online::ProfileBinding<PlayerProfile> binding(player);
+//     profiles->getMyProfile("", binding, accessToken, ...);
+//
+//     player.level++;
+//     Json::Value changes;
+//     binding.writeChanges(changes); // {"level": 2} only
+//     profiles->setMyProfile("", changes, true, accessToken,
+//         [&](const online::ProfileService&, online::Request::Result, const online::Request& request, const Json::Value&)
+//     {
+//         if (request.isSuccessful())
+//             binding.markSynced();
+//     });
+//
+// The fields are read straight from the response, a field that is missing or null keeps its value.
+
+namespace online
+{
+	template <class T>
+	class ProfileFields;
+
+	// How a value is read and written, for every type a field can be of.
+	// The default one is for the structs with a describe()
+	template <class V, class Enable = void>
+	struct ProfileValue
+	{
+		static void read(const Json::Value& value, V& out)
+		{
+			ProfileFields<V>::Get().read(value, out);
+		}
+
+		static void write(const V& value, Json::Value& out)
+		{
+			ProfileFields<V>::Get().write(value, out);
+		}
+
+		static bool equal(const V& a, const V& b)
+		{
+			return ProfileFields<V>::Get().getDifferent(a, b) == 0;
+		}
+	};
+
+	template <class V>
+	struct ProfileValue<V, typename std::enable_if<std::is_arithmetic<V>::value && !std::is_same<V, bool>::value>::type>
+	{
+		static void read(const Json::Value& value, V& out)
+		{
+			if (!value.isNumeric())
+				return;
+
+			if (std::is_floating_point<V>::value)
+				out = (V)value.asDouble();
+			else if (std::is_signed<V>::value)
+				out = (V)value.asInt64();
+			else
+				out = (V)value.asUInt64();
+		}
+
+		static void write(const V& value, Json::Value& out)
+		{
+			if (std::is_floating_point<V>::value)
+				out = (double)value;
+			else if (std::is_signed<V>::value)
+				out = (Json::Int64)value;
+			else
+				out = (Json::UInt64)value;
+		}
+
+		static bool equal(const V& a, const V& b) { return a == b; }
+	};
+
+	template <>
+	struct ProfileValue<bool>
+	{
+		static void read(const Json::Value& value, bool& out) { if (value.isBool()) out = value.asBool(); }
+		static void write(const bool& value, Json::Value& out) { out = value; }
+		static bool equal(const bool& a, const bool& b) { return a == b; }
+	};
+
+	template <>
+	struct ProfileValue<std::string>
+	{
+		static void read(const Json::Value& value, std::string& out) { if (value.isString()) out = value.asString(); }
+		static void write(const std::string& value, Json::Value& out) { out = value; }
+		static bool equal(const std::string& a, const std::string& b) { return a == b; }
+	};
+
+	// for the parts of a profile that have no fixed shape
+	template <>
+	struct ProfileValue<Json::Value>
+	{
+		static void read(const Json::Value& value, Json::Value& out) { out = value; }
+		static void write(const Json::Value& value, Json::Value& out) { out = value; }
+		static bool equal(const Json::Value& a, const Json::Value& b) { return a == b; }
+	};
+
+	template <class V>
+	struct ProfileValue< std::vector<V> >
+	{
+		static void read(const Json::Value& value, std::vector<V>& out)
+		{
+			if (!value.isArray())
+				return;
+
+			out.resize(value.size());
+
+			for (Json::ArrayIndex i = 0; i < value.size(); i++)
+			{
+				ProfileValue<V>::read(value[i], out[i]);
+			}
+		}
+
+		static void write(const std::vector<V>& value, Json::Value& out)
+		{
+			out = Json::Value(Json::arrayValue);
+			out.resize((Json::ArrayIndex)value.size());
+
+			for (size_t i = 0; i < value.size(); i++)
+			{
+				ProfileValue<V>::write(value[i], out[(Json::ArrayIndex)i]);
+			}
+		}
+
+		static bool equal(const std::vector<V>& a, const std::vector<V>& b)
+		{
+			if (a.size() != b.size())
+				return false;
+
+			for (size_t i = 0; i < a.size(); i++)
+			{
+				if (!ProfileValue<V>::equal(a[i], b[i]))
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	template <class V>
+	struct ProfileValue< std::map<std::string, V> >
+	{
+		static void read(const Json::Value& value, std::map<std::string, V>& out)
+		{
+			if (!value.isObject())
+				return;
+
+			out.clear();
+
+			for (Json::ValueConstIterator it = value.begin(); it != value.end(); it++)
+			{
+				ProfileValue<V>::read(*it, out[it.name()]);
+			}
+		}
+
+		static void write(const std::map<std::string, V>& value, Json::Value& out)
+		{
+			out = Json::Value(Json::objectValue);
+
+			for (const typename std::map<std::string, V>::value_type& entry: value)
+			{
+				ProfileValue<V>::write(entry.second, out[entry.first]);
+			}
+		}
+
+		static bool equal(const std::map<std::string, V>& a, const std::map<std::string, V>& b)
+		{
+			if (a.size() != b.size())
+				return false;
+
+			for (typename std::map<std::string, V>::const_iterator i = a.begin(), j = b.begin(); i != a.end(); i++, j++)
+			{
+				if (i->first != j->first || !ProfileValue<V>::equal(i->second, j->second))
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	// The fields of a struct, described once per type by its static describe()
+	template <class T>
+	class ProfileFields
+	{
+	public:
+		// one bit per field, in the order they are added
+		typedef uint64_t Mask;
+		static const size_t MAX_FIELDS = 64;
+
+	public:
+		static const ProfileFields<T>& Get()
+		{
+			static const ProfileFields<T> fields = Describe();
+			return fields;
+		}
+
+		template <class V>
+		ProfileFields<T>& add(const char* name, V T::* member)
+		{
+			OnlineAssert(m_fields.size() < MAX_FIELDS, "Too many fields in a profile binding.");
+
+			// the mask has no bit for it
+			if (m_fields.size() >= MAX_FIELDS)
+			{
+				Log::get() << "Profile field " << name << " is ignored, no more than " << MAX_FIELDS << " fields are supported" << std::endl;
+				return *this;
+			}
+
+			Field field;
+
+			field.name = name;
+			field.read = [member](const Json::Value& value, T& object) { ProfileValue<V>::read(value, object.*member); };
+			field.write = [member](const T& object, Json::Value& value) { ProfileValue<V>::write(object.*member, value); };
+			field.equal = [member](const T& a, const T& b) { return ProfileValue<V>::equal(a.*member, b.*member); };
+
+			m_fields.push_back(field);
+			return *this;
+		}
+
+		size_t size() const { return m_fields.size(); }
+		const char* getName(size_t index) const { return m_fields[index].name; }
+
+		void read(const Json::Value& value, T& object) const
+		{
+			if (!value.isObject())
+				return;
+
+			for (const Field& field: m_fields)
+			{
+				const Json::Value& member = value[field.name];
+
+				if (!member.isNull())
+				{
+					field.read(member, object);
+				}
+			}
+		}
+
+		void write(const T& object, Json::Value& value, Mask mask = ~Mask(0)) const
+		{
+			if (!value.isObject())
+			{
+				value = Json::Value(Json::objectValue);
+			}
+
+			for (size_t i = 0; i < m_fields.size(); i++)
+			{
+				if (mask & (Mask(1) << i))
+				{
+					m_fields[i].write(object, value[m_fields[i].name]);
+				}
+			}
+		}
+
+		// the fields that differ between the two
+		Mask getDifferent(const T& a, const T& b) const
+		{
+			Mask mask = 0;
+
+			for (size_t i = 0; i < m_fields.size(); i++)
+			{
+				if (!m_fields[i].equal(a, b))
+				{
+					mask |= Mask(1) << i;
+				}
+			}
+
+			return mask;
+		}
+
+	private:
+		struct Field
+		{
+			const char* name;
+			std::function< void(const Json::Value&, T&) > read;
+			std::function< void(const T&, Json::Value&) > write;
+			std::function< bool(const T&, const T&) > equal;
+		};
+
+		static ProfileFields<T> Describe()
+		{
+			ProfileFields<T> fields;
+			T::describe(fields);
+			return fields;
+		}
+
+	private:
+		std::vector<Field> m_fields;
+	};
+
+	template <class T>
+	const size_t ProfileFields<T>::MAX_FIELDS;
+
+	// A UserProfile over a struct with a describe(), that also knows what has been changed
+	// in it since it's been read from (or saved to) the server
+	template <class T>
+	class ProfileBinding : public UserProfile
+	{
+	public:
+		typedef typename ProfileFields<T>::Mask Mask;
+
+	public:
+		ProfileBinding(T& object) :
+			m_object(object),
+			m_synced(object)
+		{}
+
+		T& get() { return m_object; }
+		const T& get() const { return m_object; }
+
+		Mask getDirty() const { return ProfileFields<T>::Get().getDifferent(m_object, m_synced); }
+		bool isDirty() const { return getDirty() != 0; }
+
+		// only the changed fields, for a merging setProfile
+		void writeChanges(Json::Value& profile) const
+		{
+			ProfileFields<T>::Get().write(m_object, profile, getDirty());
+		}
+
+		// once the changes have been saved
+		void markSynced() { m_synced = m_object; }
+
+	protected:
+		virtual void read(const Json::Value& profile) override
+		{
+			ProfileFields<T>::Get().read(profile, m_object);
+			m_synced = m_object;
+		}
+
+		virtual void write(Json::Value& profile) const override
+		{
+			ProfileFields<T>::Get().write(m_object, profile);
+		}
+
+	private:
+		T& m_object;
+		T m_synced;
+	};
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef ONLINE_ProfileCache_H
+#define ONLINE_ProfileCache_H
+
+#include <json/value.h>
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace online
+{
+	// The profiles (or parts of them) of the accounts, by account and path ("stats/wins"),
+	// the least recently used ones are dropped once there are too many.
+	// A lookup of a path is served by any of its parents as well, so a whole profile
+	// cached once answers the lookups of every field of it.
+	class ProfileCache
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Policy
+		{
+			Policy() :
+				enabled(false),
+				ttl(30.0f),
+				maxEntries(1024)
+			{}
+
+			// off unless asked for, so the lookups keep going to the server as they always did
+			bool enabled;
+			// seconds an entry stays valid for
+			float ttl;
+			size_t maxEntries;
+		};
+
+	public:
+		ProfileCache();
+
+		void setPolicy(const Policy& policy);
+		const Policy& getPolicy() const { return m_policy; }
+		bool isEnabled() const { return m_policy.enabled; }
+
+		// false if nothing valid is cached at the path or above it; a path missing from
+		// a cached parent is null, the same as a field /profiles has not returned
+		bool get(const std::string& account, const std::string& path, Json::Value& profile);
+		void put(const std::string& account, const std::string& path, const Json::Value& profile);
+
+		// drops everything of the account the path overlaps with: the path itself, its children
+		// and its parents; the whole account if the path is empty
+		void invalidate(const std::string& account, const std::string& path = "");
+		void clear();
+
+		size_t size() const { return m_entries.size(); }
+
+	private:
+		struct Entry
+		{
+			std::string account;
+			std::string path;
+			Json::Value profile;
+			Clock::time_point expires;
+		};
+
+		// most recently used first
+		typedef std::list<Entry> Entries;
+
+		static std::string key(const std::string& account, const std::string& path);
+		static bool overlaps(const std::string& a, const std::string& b);
+
+		void remove(Entries::iterator it);
+		void trim();
+
+	private:
+		Policy m_policy;
+		Entries m_entries;
+		std::unordered_map<std::string, Entries::iterator> m_index;
+	};
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef ONLINE_ScoreQueue_H
+#define ONLINE_ScoreQueue_H
+
+#include "requests/Request.h"
+
+#include <json/value.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace online
+{
+	typedef std::shared_ptr< class ScoreQueue > ScoreQueuePtr;
+
+	// Holds the scores posted to the leaderboards and the events, and sends them once in a while instead
+	// of right away. Only the best score per leaderboard is sent, the scores of an event are summed up.
+	// The pending scores are kept in the storage, so they are sent after a restart if they could not be
+	// before, and the queue backs off once the server says there are too many requests.
+	// A score belongs to the account logged in when it's posted and is only sent while that account
+	// is logged in; the ones posted before any login go to the first account that logs in.
+	class ScoreQueue
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Policy
+		{
+			Policy() :
+				flushInterval(10.0f),
+				maxPerFlush(10),
+				retryInterval(15.0f),
+				maxRetryInterval(300.0f)
+			{}
+
+			// seconds between the flushes
+			float flushInterval;
+			// at most that many requests are sent at a time
+			size_t maxPerFlush;
+			// seconds to wait after a failure, doubled with every failure in a row up to maxRetryInterval
+			float retryInterval;
+			float maxRetryInterval;
+		};
+
+		enum Kind
+		{
+			LEADERBOARD = 0,
+			EVENT = 1
+		};
+
+		// a score has reached the server (or has been rejected by it for good)
+		typedef std::function< void(Kind kind, const std::string& id, Request::Result result) > SubmittedCallback;
+
+	public:
+		static ScoreQueuePtr Create();
+		virtual ~ScoreQueue();
+
+		void setPolicy(const Policy& policy) { m_policy = policy; }
+		const Policy& getPolicy() const { return m_policy; }
+
+		void setOnSubmitted(SubmittedCallback callback) { m_onSubmitted = callback; }
+
+		// the best one of the scores posted within the interval is sent, according to the order ("asc" or "desc")
+		void postLeaderboardScore(const std::string& name, const std::string& order, float score,
+			const std::string& displayName, int expireIn, const Json::Value& profile = Json::Value());
+
+		// the scores added within the interval are sent as one
+		void addEventScore(const std::string& eventId, uint64_t score, bool autoJoin = true,
+			const std::string& leaderboardDisplayName = "", uint64_t leaderboardExpireIn = 0);
+
+		// sends the pending scores on the next update, regardless of the interval
+		void flush();
+
+		size_t getPending() const { return m_pending.size(); }
+
+		// called every update by the runtime
+		void update();
+
+	protected:
+		ScoreQueue();
+		bool init();
+
+	private:
+		struct Pending
+		{
+			Pending() :
+				kind(LEADERBOARD),
+				score(0),
+				sent(0),
+				sending(false)
+			{}
+
+			Kind kind;
+			// empty if nobody was logged in
+			std::string account;
+			std::string id;
+			// the order of a leaderboard
+			std::string order;
+			double score;
+			// what is being sent right now
+			double sent;
+			bool sending;
+			Json::Value options;
+		};
+
+		static std::string key(const std::string& account, Kind kind, const std::string& id, const std::string& order);
+
+		void add(const std::string& account, Kind kind, const std::string& id, const std::string& order,
+			double score, const Json::Value& options);
+		// the scores posted before the login become the ones of the account
+		void adopt(const std::string& account);
+		std::string getCurrentAccount() const;
+		void load();
+		void save();
+		void send(const std::string& key);
+		void sent(const std::string& key, Request::Result result, const Request& request);
+
+	private:
+		Policy m_policy;
+		SubmittedCallback m_onSubmitted;
+
+		std::map<std::string, Pending> m_pending;
+
+		bool m_loaded;
+		Clock::time_point m_nextFlush;
+		// seconds, 0 unless the last attempt has failed
+		float m_backoff;
+	};
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef ONLINE_SocialGraph_H
+#define ONLINE_SocialGraph_H
+
+#include "services/SocialService.h"
+
+#include <json/value.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace online
+{
+	typedef std::shared_ptr< class SocialGraph > SocialGraphPtr;
+
+	// A local copy of the connections and the requests of the player, kept up to date by the changes
+	// the player makes through it and by the notifications of a message session, so it's not fetched
+	// again every time a friend list is shown. When it is fetched, the lists come without the profiles,
+	// and only the profiles of the accounts that are not in the lists yet are requested (through
+	// ProfileService). Nothing is kept of the accounts that are gone from the lists.
+	class SocialGraph : public std::enable_shared_from_this<SocialGraph>
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+		typedef std::function< void(const SocialGraph& graph, Request::Result result) > Callback;
+		typedef std::function< void(const SocialGraph& graph) > ChangedCallback;
+
+		typedef std::unordered_map<std::string, SocialRequest> Requests;
+
+		struct Policy
+		{
+			Policy() :
+				maxAge(300.0f),
+				incomingRequestType("social_request"),
+				approvedType("social_request_approved"),
+				rejectedType("social_request_rejected"),
+				deletedType("social_connection_deleted")
+			{}
+
+			// seconds a sync stays fresh for, unless a change can't be applied locally
+			float maxAge;
+
+			// the message types of the notifications, sent along with the payload given as 'notify'
+			std::string incomingRequestType;
+			std::string approvedType;
+			std::string rejectedType;
+			std::string deletedType;
+		};
+
+	public:
+		static SocialGraphPtr Create(const SocialServicePtr& social, const std::string& accessToken,
+			const std::set<std::string>& profileFields);
+		virtual ~SocialGraph();
+
+		void setPolicy(const Policy& policy) { m_policy = policy; }
+		const Policy& getPolicy() const { return m_policy; }
+		void setAccessToken(const std::string& accessToken) { m_accessToken = accessToken; }
+
+		// fetches everything unless the local copy is fresh enough, the callback is called right away if it is
+		void sync(Callback callback, bool force = false);
+		bool isSynced() const { return m_synced; }
+		// the next sync fetches everything again
+		void invalidate() { m_stale = true; }
+
+		const SocialConnections& getConnections() const { return m_connections; }
+		// by key
+		const Requests& getRequests() const { return m_requests; }
+		// changes with every change, for the screens to know when to redraw
+		uint64_t getRevision() const { return m_revision; }
+
+		void setOnChanged(ChangedCallback callback) { m_onChanged = callback; }
+
+		// to be called with every message of a message session, true if it has been a social one
+		bool handleMessage(const std::string& sender, const std::string& messageType, const Json::Value& payload);
+
+		// the same as the ones of SocialService, with the result applied locally
+		void addConnection(const std::string& account, SocialService::AddConnectionsCallback callback,
+			bool approval = true, const Json::Value& notify = Json::Value(), const Json::Value& payload = Json::Value());
+		void deleteConnection(const std::string& account, SocialService::DeleteConnectionsCallback callback,
+			const Json::Value& notify = Json::Value());
+		void approveConnection(const std::string& account, const std::string& key,
+			SocialService::ApproveConnectionsCallback callback, const Json::Value& notify = Json::Value());
+		void rejectConnection(const std::string& account, const std::string& key,
+			SocialService::RejectConnectionsCallback callback, const Json::Value& notify = Json::Value());
+
+	protected:
+		SocialGraph(const SocialServicePtr& social, const std::string& accessToken, const std::set<std::string>& profileFields);
+		bool init();
+
+	private:
+		void fetched(Request::Result result);
+		void fetchProfiles(const std::set<std::string>& accounts);
+		void changed();
+		void removeRequestTo(const std::string& account);
+		// the other side of the request
+		static const std::string& getAccount(const SocialRequest& request);
+
+	private:
+		std::weak_ptr<SocialService> m_social;
+		std::string m_accessToken;
+		std::set<std::string> m_profileFields;
+		Policy m_policy;
+
+		SocialConnections m_connections;
+		Requests m_requests;
+		// being fetched, the connections and the requests
+		SocialConnections m_fetchedConnections;
+		Requests m_fetchedRequests;
+		int m_fetching;
+		Request::Result m_fetchResult;
+		std::vector<Callback> m_syncCallbacks;
+
+		bool m_synced;
+		bool m_stale;
+		Clock::time_point m_syncedAt;
+		uint64_t m_revision;
+		ChangedCallback m_onChanged;
+	};
+};
+
+#endif
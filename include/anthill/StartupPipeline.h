@@ -0,0 +1,86 @@
+
+#ifndef ONLINE_StartupPipeline_H
+#define ONLINE_StartupPipeline_H
+
+#include "Pipeline.h"
+#include "states/StateMachine.h"
+#include "services/LoginService.h"
+
+#include <json/value.h>
+#include <unordered_map>
+
+namespace online
+{
+	typedef std::shared_ptr< class StartupPipeline > StartupPipelinePtr;
+
+	// The runtime startup as a pipeline: environment, then discovery, then authentication.
+	// Authentication runs the usual authentication states. When the login service location
+	// is known upfront, it starts right away, alongside the environment and discovery stages.
+	//
+	// Games add their own stages on top, e.g. config and DLC updates depending on DISCOVERY only,
+	// profile depending on AUTHENTICATION, and get per-stage timings once it's all done.
+	// Please note this shared pointer should be stored somewhere until the pipeline completes.
+	// The background refresh of a warm start holds the pipeline by itself until it's over.
+	class StartupPipeline : public Pipeline
+	{
+	public:
+		static const std::string ENVIRONMENT;
+		static const std::string DISCOVERY;
+		static const std::string AUTHENTICATION;
+
+		// The last environment, discovered services and validated access token are kept in the Storage.
+		// While they are fresh enough, the stages complete from that snapshot immediately, and the
+		// real requests run in the background to revalidate it.
+		struct WarmStart
+		{
+			WarmStart() :
+				enabled(true),
+				servicesTTL(24 * 60 * 60),
+				tokenTTL(60 * 60)
+			{}
+
+			bool enabled;
+			// seconds
+			int servicesTTL;
+			int tokenTTL;
+		};
+
+	public:
+		static StartupPipelinePtr Create(const WarmStart& warmStart = WarmStart());
+		virtual ~StartupPipeline();
+
+		bool isWarmStart() const { return m_warmServices; }
+
+	protected:
+		StartupPipeline(const WarmStart& warmStart);
+		bool init();
+
+	private:
+		// a null 'done' means a background refresh of the snapshot
+		void getEnvironment(StageDone done);
+		void discoverServices(StageDone done);
+		void authenticate(StageDone done);
+
+		// tries the stage again later, doubling the delay each time, same as RetryState does
+		void retry(const std::string& stage, std::function<void()> attempt);
+
+		std::string getSnapshotVersion() const;
+		void loadSnapshot();
+		void saveSnapshot();
+		void rememberToken();
+		void revalidateToken();
+		void storeToken(const std::string& accessToken, const std::string& credential,
+			const std::string& account, const LoginService::Scopes& scopes);
+
+	private:
+		StateMachinePtr m_authentication;
+		std::unordered_map<std::string, float> m_retryTimes;
+
+		WarmStart m_warmStart;
+		Json::Value m_snapshot;
+		bool m_warmServices;
+		bool m_warmToken;
+	};
+};
+
+#endif
@@ -15,8 +15,15 @@ namespace online
 		static const std::string StorageUsernameField;
 		static const std::string StoragePasswordField;
 		static const std::string StorageAccessTokeneField;
+		static const std::string StorageStartupSnapshotField;
+		static const std::string StoragePendingScoresField;
+		// followed by the name of the store
+		static const std::string StorageStoreCatalogField;
+		static const std::string StorageBundlesField;
 
 	public:
+		virtual ~Storage() {}
+
 		virtual void set(const std::string& key, const std::string& value) = 0;
 		virtual std::string get(const std::string& key) const = 0;
 		virtual bool has(const std::string& key) const = 0;
@@ -0,0 +1,121 @@
+#ifndef ONLINE_StoreCatalog_H
+#define ONLINE_StoreCatalog_H
+
+#include <json/value.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace online
+{
+	typedef std::shared_ptr< class StoreCatalog > StoreCatalogPtr;
+
+	// The items of a store in flat arrays, with the lookups by id and category prepared once it's built.
+	// The strings (ids, categories, currencies, titles) are interned and referred to by index,
+	// and the IAP billing of an item refers to its tier by index as well.
+	class StoreCatalog
+	{
+	public:
+		typedef uint32_t StringId;
+		typedef uint32_t Index;
+		static const Index NONE;
+
+		enum class Billing
+		{
+			None,
+			IAP,
+			Offline
+		};
+
+		struct Price
+		{
+			StringId currency;
+			StringId format;
+			StringId title;
+			StringId symbol;
+			StringId label;
+			int price;
+		};
+
+		struct Tier
+		{
+			StringId name;
+			StringId product;
+			// the prices of the tier are [firstPrice, firstPrice + prices)
+			Index firstPrice;
+			Index prices;
+		};
+
+		struct Item
+		{
+			StringId id;
+			StringId category;
+			Billing billing;
+			// IAP billing
+			Index tier;
+			// offline billing
+			StringId currency;
+			int amount;
+		};
+
+	public:
+		// the response of the store service, "store" with "tiers" and "items"
+		static StoreCatalogPtr Create(const std::string& name, const Json::Value& data);
+
+		const std::string& getName() const { return m_name; }
+
+		const std::vector<Item>& getItems() const { return m_items; }
+		const std::vector<Tier>& getTiers() const { return m_tiers; }
+
+		// null if there's no such item
+		const Item* findItem(const std::string& id) const;
+		// the indices of the items of the category, in the order of the store
+		const std::vector<Index>& getCategory(const std::string& category) const;
+		std::vector<std::string> getCategories() const;
+
+		const Tier* findTier(const std::string& name) const;
+		// null if the item is not an IAP, or its tier is unknown
+		const Tier* getTier(const Item& item) const;
+		// null if the tier has no price in that currency
+		const Price* findPrice(const Tier& tier, const std::string& currency) const;
+		const Price* getPrices(const Tier& tier) const { return tier.prices ? &m_prices[tier.firstPrice] : nullptr; }
+
+		const std::string& getString(StringId id) const { return m_strings[id]; }
+		std::string getFormattedPrice(const Price& price, int amount = 1) const;
+
+		const Json::Value& getPublicPayload(const Item& item) const { return m_payloads[&item - &m_items[0]]; }
+		const Json::Value& getOptions(const Item& item) const { return m_options[&item - &m_items[0]]; }
+
+	protected:
+		StoreCatalog(const std::string& name);
+		bool init(const Json::Value& data);
+
+	private:
+		StringId intern(const std::string& value);
+		// NONE if the string is not there at all
+		StringId find(const std::string& value) const;
+
+	private:
+		std::string m_name;
+
+		std::vector<Item> m_items;
+		std::vector<Tier> m_tiers;
+		std::vector<Price> m_prices;
+		// by item index
+		std::vector<Json::Value> m_payloads;
+		std::vector<Json::Value> m_options;
+
+		std::vector<std::string> m_strings;
+		std::unordered_map<std::string, StringId> m_stringIds;
+
+		// by string id
+		std::unordered_map<StringId, Index> m_itemsById;
+		std::unordered_map<StringId, Index> m_tiersByName;
+		std::unordered_map<StringId, std::vector<Index> > m_categories;
+	};
+};
+
+#endif
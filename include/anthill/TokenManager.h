@@ -0,0 +1,86 @@
+
+#ifndef ONLINE_TokenManager_H
+#define ONLINE_TokenManager_H
+
+#include "requests/Request.h"
+
+#include <ctime>
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace online
+{
+	typedef std::shared_ptr< class TokenManager > TokenManagerPtr;
+
+	// Keeps the current access token of the LoginService alive.
+	// The token is extended in the background a bit before it expires, and a request that
+	// fails with 401/403 because of an expired token is held until the token is refreshed,
+	// and then replayed with the new one (once), instead of failing back to the caller.
+	class TokenManager
+	{
+	public:
+		struct Policy
+		{
+			Policy() :
+				enabled(true),
+				refreshAhead(5 * 60),
+				minRefreshInterval(30),
+				retryInterval(10)
+			{}
+
+			bool enabled;
+			// seconds before the expiration to extend the token at
+			int refreshAhead;
+			// the token is not refreshed again within that time after a failed request
+			// unless it's about to expire, so legitimate 403s do not cause a refresh every time
+			int minRefreshInterval;
+			// seconds between the attempts if the refresh has failed
+			int retryInterval;
+		};
+
+	public:
+		static TokenManagerPtr Create();
+		virtual ~TokenManager();
+
+		void setPolicy(const Policy& policy) { m_policy = policy; }
+		const Policy& getPolicy() const { return m_policy; }
+
+		// 0 if the expiration time of the token is unknown
+		std::time_t getExpiresAt() const { return m_expiresAt; }
+		bool isRefreshing() const { return m_refreshing; }
+
+		// extends the current token right away
+		void refresh();
+
+		// called every update, picks up the token changes and refreshes it on time
+		void update();
+
+		// a request with an access token has failed with 401/403, true if it's been taken over
+		bool intercept(const RequestPtr& request);
+
+	protected:
+		TokenManager();
+		bool init();
+
+	private:
+		void tokenChanged(const std::string& accessToken);
+		void replayPending();
+		void completePending();
+
+	private:
+		Policy m_policy;
+
+		std::string m_accessToken;
+		std::set<std::string> m_scopes;
+		std::time_t m_expiresAt;
+		std::time_t m_lastRefresh;
+		std::time_t m_nextAttempt;
+		bool m_refreshing;
+
+		std::list<RequestPtr> m_pending;
+	};
+};
+
+#endif
@@ -0,0 +1,117 @@
+
+#ifndef ONLINE_Tracing_H
+#define ONLINE_Tracing_H
+
+#include <json/value.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace online
+{
+	// Spans with ids and parent links, saved as Chrome trace events
+	// (load the file in chrome://tracing or https://ui.perfetto.dev).
+	//
+	// Requests, JSON-RPC calls and state machine states open spans on their own. A span is the parent of
+	// every span started inside its callbacks, so a login flow shows up as a chain from the
+	// first request to the last state. Nothing is recorded until the tracer is enabled.
+	//
+	//     online::Tracer::get().setEnabled(true);
+	//     ...
+	//     online::Tracer::get().save("session.trace.json");
+	class Tracer
+	{
+	public:
+		typedef uint64_t SpanId;
+		typedef std::chrono::steady_clock Clock;
+
+		// makes the span the parent of the spans started on this thread, for the lifetime of the object
+		class Scope
+		{
+		public:
+			Scope(SpanId span);
+			~Scope();
+
+		private:
+			SpanId m_previous;
+		};
+
+		// a synchronous span for the lifetime of the object
+		class Span
+		{
+		public:
+			Span(const char* category, const std::string& name);
+			~Span();
+
+			SpanId getId() const { return m_id; }
+
+		private:
+			SpanId m_id;
+			Scope m_scope;
+		};
+
+	public:
+		static Tracer& get();
+
+		void setEnabled(bool enabled) { m_enabled = enabled; }
+		bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+		// once that many events are recorded, the rest are dropped
+		void setCapacity(size_t capacity) { m_capacity = capacity; }
+
+		// starts a span under the current one of this thread, 0 if tracing is disabled
+		SpanId begin(const char* category, const std::string& name, const Json::Value& args = Json::Value::null);
+		void end(SpanId span, const Json::Value& args = Json::Value::null);
+
+		// the span the new spans of this thread are parented to
+		static SpanId getCurrent();
+
+		// writes the events recorded so far in the Chrome trace-event format
+		bool save(const std::string& path);
+		void clear();
+
+	private:
+		Tracer();
+
+		struct Event
+		{
+			char m_phase;
+			const char* m_category;
+			std::string m_name;
+			SpanId m_id;
+			SpanId m_parent;
+			int64_t m_timestamp;
+			unsigned int m_thread;
+			Json::Value m_args;
+		};
+
+		struct OpenSpan
+		{
+			SpanId m_id;
+			const char* m_category;
+			std::string m_name;
+		};
+
+		static const size_t MAX_OPEN_SPANS = 4096;
+
+		int64_t now() const;
+		void record(Event&& event);
+
+	private:
+		std::atomic<bool> m_enabled;
+		std::atomic<SpanId> m_nextId;
+		Clock::time_point m_epoch;
+		size_t m_capacity;
+
+		std::mutex m_mutex;
+		std::vector<Event> m_events;
+		std::vector<OpenSpan> m_open;
+		unsigned int m_dropped;
+	};
+};
+
+#endif
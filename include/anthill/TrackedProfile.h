@@ -0,0 +1,91 @@
+#ifndef ONLINE_TrackedProfile_H
+#define ONLINE_TrackedProfile_H
+
+#include "services/ProfileService.h"
+
+#include <json/value.h>
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace online
+{
+	typedef std::shared_ptr< class TrackedProfile > TrackedProfilePtr;
+
+	// A local copy of a profile that remembers what has been changed in it.
+	// The changes made within the interval are sent together, as a merge of only the changed paths,
+	// and the profile the server returns becomes the local copy, with the changes made meanwhile on top.
+	//
+	//     online::TrackedProfilePtr profile = online::TrackedProfile::Create(profiles, accessToken);
+	//     profile->load(...);
+	//     profile->set("stats/kills", kills);
+	//     profile->set("stats/deaths", deaths); // both go in one request in a few seconds
+	class TrackedProfile : public std::enable_shared_from_this<TrackedProfile>
+	{
+	public:
+		typedef std::function< void(const TrackedProfile& profile, Request::Result result) > Callback;
+
+	public:
+		static TrackedProfilePtr Create(const ProfileServicePtr& service, const std::string& accessToken,
+			const std::string& account = "me", float interval = 5.0f);
+		virtual ~TrackedProfile();
+
+		void setAccessToken(const std::string& accessToken) { m_accessToken = accessToken; }
+		void setInterval(float interval) { m_interval = interval; }
+
+		// with the changes that are not sent yet
+		const Json::Value& get() const { return m_profile; }
+		// null if there's nothing at the path
+		const Json::Value& get(const std::string& path) const;
+
+		// "a/b/c", the objects on the way are created if needed
+		void set(const std::string& path, const Json::Value& value);
+
+		// replaces the local copy with the one from the server, keeping the changes not sent yet
+		void load(Callback callback = nullptr);
+		// sends the changes right away
+		void flush(Callback callback = nullptr);
+
+		bool isDirty() const { return !m_dirty.empty(); }
+		bool isSending() const { return m_sending; }
+
+		// called after every flush, successful or not
+		void setOnSynced(Callback callback) { m_onSynced = callback; }
+
+	protected:
+		TrackedProfile(const ProfileServicePtr& service, const std::string& accessToken, const std::string& account, float interval);
+		bool init();
+
+	private:
+		void schedule();
+		void send();
+
+		// the changed paths, with the ones under another changed path left out
+		Json::Value buildPatch(const std::set<std::string>& paths) const;
+		void applyDirty(Json::Value& profile) const;
+
+	private:
+		std::weak_ptr<ProfileService> m_service;
+		std::string m_accessToken;
+		std::string m_account;
+		float m_interval;
+
+		Json::Value m_profile;
+		std::set<std::string> m_dirty;
+		// being sent right now
+		std::set<std::string> m_sent;
+
+		bool m_scheduled;
+		bool m_sending;
+		// flushed while another save was in flight, called once their changes are sent
+		std::vector<Callback> m_flushCallbacks;
+		// called once the save in flight is done
+		std::vector<Callback> m_sentCallbacks;
+		Callback m_onSynced;
+	};
+};
+
+#endif
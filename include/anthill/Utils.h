@@ -9,6 +9,7 @@
 #include <set>
 #include <unordered_map>
 #include <functional>
+#include <random>
 
 #ifndef NDEBUG
 #define OnlineAssert(Expr, Msg) \
@@ -34,11 +35,17 @@ namespace online
 
 	std::string join(const std::set<std::string>& elements, const char* const separator);
 	std::string random_string(size_t length);
+	// a generator of the calling thread, seeded once from std::random_device
+	std::mt19937& random_engine();
     std::string url_encode(const std::string &value);
     std::string url_decode(const std::string &value);
+    // accepts both the standard and the url-safe alphabets, padding is optional
+    std::string base64_decode(const std::string &value);
     std::unordered_map<std::string, std::string> parse_query_arguments(const std::string &url);
     std::time_t get_utc_timestamp();
     std::time_t parse_time(const std::string& time);
+    // "Sun, 06 Nov 1994 08:49:37 GMT", 0 if it's not that
+    std::time_t parse_http_date(const std::string& date);
 	std::string dump_time(std::time_t time, bool includeDate = true, bool local = true);
     bool list_files_in_directory(const std::string& directory, std::list<std::string>& files, std::function<bool(const std::string&)> predicate = nullptr);
 
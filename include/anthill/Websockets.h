@@ -5,10 +5,42 @@
 #include "JsonRPC.h"
 #include <uWS.h>
 #include <thread>
+#include <random>
+#include <list>
 
 namespace online
 {
     typedef std::shared_ptr< class WebsocketRPC > WebsocketRPCPtr;
+    typedef std::shared_ptr< class WebsocketHub > WebsocketHubPtr;
+    
+    // A single event loop shared by every websocket connection of the runtime.
+    // Each connection gets its own client group, so handlers stay per connection
+    // while the loop is run once per update for all of them.
+    class WebsocketHub
+    {
+    public:
+        static WebsocketHubPtr Create();
+        ~WebsocketHub();
+        
+        uWS::Group<uWS::CLIENT>* createGroup();
+        
+        // terminates the group's sockets, the group itself is freed on the next update
+        void releaseGroup(uWS::Group<uWS::CLIENT>* group);
+        
+        void connect(const std::string& uri, const std::map<std::string, std::string>& extraHeaders,
+                     uWS::Group<uWS::CLIENT>* group);
+        
+        // processes pending network events; when wait is true, blocks until at least one arrives
+        void update(bool wait = false);
+        bool isAlive();
+        
+    protected:
+        WebsocketHub();
+        
+    private:
+        uWS::Hub m_hub;
+        std::list<uWS::Group<uWS::CLIENT>*> m_released;
+    };
 
     class WebsocketRPC: public JsonRPC
     {
@@ -16,9 +48,68 @@ namespace online
         typedef std::unordered_map<std::string, std::string> Options;
         typedef std::function<void(bool success, int response)> ConnectCallback;
         typedef std::function<void(int code, const std::string& reason)> DisconnectCallback;
+        typedef std::function<void(int attempt, float delay)> ReconnectingCallback;
+        typedef std::function<void()> ReconnectedCallback;
+        
+        // Describes how an unexpectedly lost connection is re-established.
+        // Normal closures (1000) and application-defined codes (3000+) are never retried.
+        struct ReconnectPolicy
+        {
+            ReconnectPolicy() :
+                enabled(false),
+                maxAttempts(5),
+                initialDelay(0.5f),
+                maxDelay(15.0f),
+                multiplier(2.0f),
+                jitter(0.5f)
+            {}
+            
+            bool enabled;
+            int maxAttempts;
+            float initialDelay;
+            float maxDelay;
+            float multiplier;
+            // a fraction of each delay that is randomized, so clients do not reconnect in lockstep
+            float jitter;
+        };
+        
+        // Pings the server periodically. A peer that misses maxMissedPongs in a row is considered
+        // dead and the socket is dropped, which lets the reconnect policy take over.
+        struct KeepalivePolicy
+        {
+            KeepalivePolicy() :
+                enabled(false),
+                interval(5.0f),
+                maxMissedPongs(3)
+            {}
+            
+            bool enabled;
+            float interval;
+            int maxMissedPongs;
+        };
+        
+        // Round trip times measured by the keepalive pings, in seconds.
+        // The smoothing follows RFC 6298: rtt is the smoothed average, jitter its mean deviation.
+        struct LatencyStats
+        {
+            LatencyStats() :
+                rtt(0),
+                jitter(0),
+                lastRtt(0),
+                samples(0),
+                missedPongs(0)
+            {}
+            
+            float rtt;
+            float jitter;
+            float lastRtt;
+            int samples;
+            int missedPongs;
+        };
         
     public:
-        static WebsocketRPCPtr Create();
+        // a connection without a hub of its own joins the runtime's shared one
+        static WebsocketRPCPtr Create(const WebsocketHubPtr& hub = WebsocketHubPtr(nullptr));
         virtual void update() override;
         
         void connect(const std::string& location, const Options& options,
@@ -26,6 +117,17 @@ namespace online
                      const std::map<std::string, std::string>& extraHeaders = {});
         void disconnect(int code, const std::string& reason);
         
+        void setReconnectPolicy(const ReconnectPolicy& policy) { m_reconnectPolicy = policy; }
+        void setReconnectCallbacks(ReconnectingCallback onReconnecting, ReconnectedCallback onReconnected);
+        
+        // overrides where (and with what options) the socket reconnects, e.g. to rejoin an existing party
+        void setReconnectLocation(const std::string& location, const Options& options);
+        
+        bool isReconnecting() const { return m_reconnectAttempt > 0; }
+        
+        void setKeepalivePolicy(const KeepalivePolicy& policy) { m_keepalivePolicy = policy; }
+        const LatencyStats& getLatencyStats() const { return m_latency; }
+        
         void close();
         void terminate();
 		void waitForShutdown();
@@ -34,21 +136,56 @@ namespace online
     
         ~WebsocketRPC();
     protected:
-        WebsocketRPC();
+        WebsocketRPC(const WebsocketHubPtr& hub, bool ownsHub);
     
         virtual bool read(std::string& data) override;
         virtual void write(const std::string& data) override;
         virtual void error(int code, const std::string& message, const std::string& data) override;
+        virtual bool isWritable() const override { return m_connected && m_socket; }
         
     private:
         void onMessage(uWS::WebSocket<uWS::CLIENT> *ws, char *message, size_t length, uWS::OpCode opCode);
         
+        void onPong(uWS::WebSocket<uWS::CLIENT> *ws, char *message, size_t length);
+        
+        bool open(const std::string& location, const Options& options);
+        bool scheduleReconnect(int code);
+        void stopReconnecting();
+        void keepalive();
+        
         static void OnWrite(void *webSocket, void *data, bool cancelled, void *reserved);
         
     private:
-        uWS::Hub m_client;
+        WebsocketHubPtr m_hub;
+        uWS::Group<uWS::CLIENT>* m_group;
         uWS::WebSocket<uWS::CLIENT> *m_socket;
+        bool m_ownsHub;
+        bool m_open;
         bool m_connected;
+        bool m_closing;
+        
+        ConnectCallback m_onConnect;
+        DisconnectCallback m_onDisconnect;
+        ReconnectingCallback m_onReconnecting;
+        ReconnectedCallback m_onReconnected;
+        
+        std::string m_location;
+        Options m_options;
+        std::map<std::string, std::string> m_extraHeaders;
+        std::string m_resumeToken;
+        
+        ReconnectPolicy m_reconnectPolicy;
+        int m_reconnectAttempt;
+        bool m_reconnectPending;
+        Clock::time_point m_reconnectAt;
+        std::default_random_engine m_random;
+        
+        KeepalivePolicy m_keepalivePolicy;
+        LatencyStats m_latency;
+        unsigned int m_pingId;
+        bool m_pingOutstanding;
+        Clock::time_point m_pingSentAt;
+        Clock::time_point m_nextPingAt;
     };
 }
 
@@ -35,8 +35,7 @@ namespace online
 		FileRequest(const std::string& location, Request::Method method, std::fstream& file);
 		virtual bool init() override;
 
-		// called once the request is done
-		virtual void done() override;
+		virtual void complete() override;
         
     private:
         static int processProgress(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
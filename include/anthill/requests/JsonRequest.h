@@ -34,8 +34,8 @@ namespace online
 		JsonRequest(const std::string& location, Request::Method method);
 		virtual bool init() override;
 
-		// called once the request is done
-		virtual void done() override;
+		virtual void complete() override;
+		virtual bool rewind() override;
 
 	private:
 		bool m_responseValueValid;
@@ -4,6 +4,7 @@
 
 #define CURL_STATICLIB (1)
 #include "anthill/Log.h"
+#include "anthill/Tracing.h"
 
 
 #ifndef WIN32_LEAN_AND_MEAN
@@ -16,6 +17,7 @@
 #include "curl_easy.h"
 #include "curl_header.h"
 
+#include <chrono>
 #include <functional>
 #include <unordered_map>
 #include <istream>
@@ -25,10 +27,12 @@ namespace online
 	typedef std::shared_ptr< class Request > RequestPtr;
 
 	class AnthillRuntime;
+	class TokenManager;
 
 	class Request : public std::enable_shared_from_this<Request>
 	{
 		friend class AnthillRuntime;
+		friend class TokenManager;
 
 	public:
 		typedef std::unordered_map<std::string, std::string> Fields;
@@ -50,6 +54,7 @@ namespace online
 			CONFLICT = 409,
 			MULTIPLE_CHOISES = 300,
 			BAD_ARGUMENTS = 400,
+			UNAUTHORIZED = 401,
 			FORBIDDEN = 403,
 			NOT_FOUND = 404,
             NOT_ACCEPTABLE = 406,
@@ -96,6 +101,8 @@ namespace online
   
         void setAPIVersion(const std::string& APIVersion);
         void setFollowRedirects(bool followRedirects);
+        // seconds the whole transfer may take, 0 for no limit
+        void setTimeout(long timeout);
 
 		void addResponseHeader(const std::string& key, const std::string& value);
 		std::string getResponseHeader(const std::string& key) const;
@@ -105,6 +112,9 @@ namespace online
 		static bool isSuccessful(Result result);
         bool isCancelled() const { return m_cancelled; }
 
+        // seconds since the request has been started
+        float getElapsed() const;
+
 		void start();
         void cancel();
         
@@ -119,7 +129,10 @@ namespace online
             m_method(method),
             m_status(NONE),
             m_transport(ios),
-            m_cancelled(false)
+            m_cancelled(false),
+            m_replayed(false),
+            m_timeout(60 * 2),
+            m_span(0)
         {
         }
         
@@ -127,13 +140,27 @@ namespace online
 
 		// called once the request is done
 		virtual void done();
+
+		// delivers the response to the callbacks
+		virtual void complete();
+		Tracer::SpanId getSpan() const { return m_span; }
         
         // failed to connect to the server
         virtual void connectionError() = 0;
 
+        // prepares the response to be received once again, false if that's not possible
+        virtual bool rewind() { return false; }
+
+	private:
+		// the access token the request has been made with, if any
+		std::string getAccessToken() const;
+		// starts the request again with another access token, only once
+		bool replay(const std::string& accessToken);
+
 	private:
 		const char* m_name;
 		std::string m_location;
+		std::string m_url;
 		std::string m_responseContentType;
         std::string m_APIVersion;
 		
@@ -150,6 +177,10 @@ namespace online
 		ResponseCallback m_onResponse;
         bool m_cancelled;
         bool m_followRedirects;
+        bool m_replayed;
+        long m_timeout;
+        Tracer::SpanId m_span;
+        std::chrono::steady_clock::time_point m_started;
 	};
     
     typedef std::shared_ptr< class StringStreamRequest > StringStreamRequestPtr;
@@ -182,6 +213,13 @@ namespace online
             Log::get() << "StringStreamRequest(" << (getName() ? getName() : "Unknown") << "): <Connection Error>" << std::endl;
             m_response << "<Connection Error>";
         }
+
+        virtual bool rewind() override
+        {
+            m_response.str("");
+            m_response.clear();
+            return true;
+        }
         
     private:
 		std::stringstream m_response;
@@ -9,6 +9,7 @@
 #include "anthill/ApplicationInfo.h"
 #include <json/value.h>
 
+#include <chrono>
 #include <set>
 #include <unordered_map>
 
@@ -35,6 +36,8 @@ namespace online
         
     public:
         Event(const Json::Value& data);
+        // 'serverTime' is the time on the server the data has been received at
+        Event(const Json::Value& data, EventTime serverTime);
         
         const std::string& getId() const { return m_id; }
         const std::string& getCategory() const { return m_category; }
@@ -58,6 +61,9 @@ namespace online
         EventTime getTimeStart() const { return m_timeStart; }
         EventTime getTimeEnd() const { return m_timeEnd; }
         int getTimeLeftSeconds() const;
+
+        // the current time on the server, counted locally since the event has been received
+        EventTime getServerTime() const;
         
     private:
         std::string m_id;
@@ -74,7 +80,8 @@ namespace online
         EventTime m_timeStart;
         EventTime m_timeEnd;
         int m_timeLeft;
-        EventTime m_timeLeftNow;
+        EventTime m_serverTime;
+        std::chrono::steady_clock::time_point m_receivedAt;
         
         bool m_tournament;
         std::string m_leaderboardName;
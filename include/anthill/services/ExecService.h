@@ -56,6 +56,17 @@ namespace online
         
         bool isActive() const;
         
+        // enables automatic reconnection; the server side script state survives only if it issues a resume token
+        void setReconnectPolicy(const WebsocketRPC::ReconnectPolicy& policy);
+        // calls made between beginBatch and flush (or the next update) are sent in one frame
+        void beginBatch();
+        void flush();
+        
+        void setKeepalivePolicy(const WebsocketRPC::KeepalivePolicy& policy);
+        
+        // live round trip time to the server, measured by the keepalive pings
+        const WebsocketRPC::LatencyStats& getLatencyStats() const;
+        
     protected:
         WebsocketRPCPtr m_sockets;
         std::string m_location;
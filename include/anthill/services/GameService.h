@@ -177,9 +177,22 @@ namespace online
         
         bool isActive() const;
         
+        // enables automatic reconnection; once the party is known, the session reconnects as a reunion
+        // to that party instead of creating or searching for a new one
+        void setReconnectPolicy(const WebsocketRPC::ReconnectPolicy& policy);
+        // calls made between beginBatch and flush (or the next update) are sent in one frame
+        void beginBatch();
+        void flush();
+        
+        void setKeepalivePolicy(const WebsocketRPC::KeepalivePolicy& policy);
+        
+        // live round trip time to the server, measured by the keepalive pings
+        const WebsocketRPC::LatencyStats& getLatencyStats() const;
+        
     protected:
         WebsocketRPCPtr m_sockets;
         std::string m_location;
+        std::string m_accessToken;
         std::unordered_map<std::string, PartyMessageHandler> m_messageHandlers;
         PartySession::ListenerPtr m_listener;
     };
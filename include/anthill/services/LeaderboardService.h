@@ -54,6 +54,10 @@ namespace online
         
 		typedef std::function< void(const LeaderboardService& service, Request::Result result,
             const Request& request, const LeaderboardEntries& entries) > GetLeaderboardEntriesCallback;
+
+		// the "data" array of the response as it is, for the callers keeping the entries their own way
+		typedef std::function< void(const LeaderboardService& service, Request::Result result,
+            const Request& request, const Json::Value& data) > GetLeaderboardPageCallback;
         
     public:
         static const std::string ID;
@@ -64,7 +68,11 @@ namespace online
         virtual ~LeaderboardService();
         
 		void getLeaderboardEntries(const std::string& name, const std::string& order,
-			const std::string& accessToken, GetLeaderboardEntriesCallback callback, int limit = 100);
+			const std::string& accessToken, GetLeaderboardEntriesCallback callback, int limit = 100, int offset = 0);
+
+		// 'limit' entries starting at 'offset', or the ones around the entry of the player if 'aroundMe'
+		void getLeaderboardPage(const std::string& name, const std::string& order, int offset, int limit, bool aroundMe,
+			const std::string& accessToken, GetLeaderboardPageCallback callback);
         
 		void deleteLeaderboardEntry(const std::string& name, const std::string& order,
 			const std::string& accessToken, DeleteLeaderboardEntryCallback callback);
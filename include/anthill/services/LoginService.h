@@ -143,6 +143,12 @@ namespace online
 		const std::string& getCurrentAccessToken() const;
 		void setCurrentAccessToken(const std::string& token);
 
+		// who the current access token belongs to, as the last authentication (or validation) has told
+		void setCurrentAccount(const std::string& account, const std::string& credential, const Scopes& scopes);
+		const std::string& getCurrentAccount() const { return m_currentAccount; }
+		const std::string& getCurrentCredential() const { return m_currentCredential; }
+		const Scopes& getCurrentScopes() const { return m_currentScopes; }
+
 		void setExternalAuthenticator(const ExternalAuthenticatorPtr& externalAuthenticator) { m_externalAuthenticator = externalAuthenticator; }
 		const ExternalAuthenticatorPtr& getExternalAuthenticator() const { return m_externalAuthenticator; }
 
@@ -152,6 +158,9 @@ namespace online
 
 	private:
 		std::string m_currentToken;
+		std::string m_currentAccount;
+		std::string m_currentCredential;
+		Scopes m_currentScopes;
 		ExternalAuthenticatorPtr m_externalAuthenticator;
 	};
 
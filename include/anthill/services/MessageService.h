@@ -46,6 +46,13 @@ namespace online
         
         bool isConnected() const;
         
+        // enables automatic reconnection; 'mark_as_read' calls in flight are sent again once reconnected
+        void setReconnectPolicy(const WebsocketRPC::ReconnectPolicy& policy);
+        void setKeepalivePolicy(const WebsocketRPC::KeepalivePolicy& policy);
+        
+        // live round trip time to the server, measured by the keepalive pings
+        const WebsocketRPC::LatencyStats& getLatencyStats() const;
+        
         void disconnect(int code, const std::string& reason);
         void connect(const std::string& location, const WebsocketRPC::Options& options,
             WebsocketRPC::ConnectCallback onConnect, WebsocketRPC::DisconnectCallback onDisconnect);
@@ -5,10 +5,13 @@
 #include "Service.h"
 #include "../requests/Request.h"
 #include "../ApplicationInfo.h"
+#include "../ProfileCache.h"
+#include "../requests/JsonRequest.h"
 #include <json/value.h>
 
 #include <set>
 #include <unordered_map>
+#include <vector>
 
 namespace online
 {
@@ -42,6 +45,23 @@ namespace online
         
         typedef std::function< void(const ProfileService& service, Request::Result result, const Request& request,
 			const Json::Value& profile) > SetProfileCallback;
+
+		// getProfile of other accounts is gathered for a short while and sent as one getMassProfiles,
+		// each of them is answered with the whole profile, same as when it's not batched
+		struct BatchPolicy
+		{
+			BatchPolicy() :
+				enabled(false),
+				window(0),
+				maxAccounts(50)
+			{}
+
+			bool enabled;
+			// seconds to gather the lookups for, 0 to send them on the next update
+			float window;
+			// a batch is sent right away once it has that many accounts
+			size_t maxAccounts;
+		};
         
     public:
         static const std::string ID;
@@ -68,11 +88,52 @@ namespace online
 		void getMyProfile(const std::string& path, UserProfile& profile, const std::string& accessToken, GetUserProfileCallback callback);
 		void setMyProfile(const std::string& path, const UserProfile& profile, bool merge, const std::string& accessToken, SetUserProfileCallback callback);
 
+		// the lookups above are answered from it while it's enabled, the successful
+		// updates of the profiles invalidate the parts they have changed
+		ProfileCache& getCache() { return m_cache; }
+		void setCachePolicy(const ProfileCache::Policy& policy) { m_cache.setPolicy(policy); }
+
+		void setBatchPolicy(const BatchPolicy& policy) { m_batchPolicy = policy; }
+		const BatchPolicy& getBatchPolicy() const { return m_batchPolicy; }
+
     protected:
         ProfileService(const std::string& location);
         bool init();
         
     private:
+		void requestProfiles(const std::set<std::string>& accounts, const std::set<std::string>& profileFields,
+			const std::string& accessToken, GetMassUserProfilesCallback callback);
+
+		void requestProfile(const std::string& account, const std::string& path, const std::string& accessToken, GetProfileCallback callback);
+
+		void batchProfile(const std::string& account, const std::string& accessToken, GetProfileCallback callback);
+		void flushBatch(const std::string& accessToken);
+
+		// "me" is cached for one access token only
+		void checkMe(const std::string& account, const std::string& accessToken);
+
+		// a response for the callbacks served from the cache
+		const Request& getCachedRequest();
+
+	private:
+		struct BatchedLookup
+		{
+			std::string account;
+			GetProfileCallback callback;
+		};
+
+		struct Batch
+		{
+			std::set<std::string> accounts;
+			std::vector<BatchedLookup> lookups;
+		};
+
+		ProfileCache m_cache;
+		BatchPolicy m_batchPolicy;
+		// by access token
+		std::unordered_map<std::string, Batch> m_batches;
+		std::string m_myAccessToken;
+		JsonRequestPtr m_cachedRequest;
     };
 };
 
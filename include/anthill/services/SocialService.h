@@ -22,6 +22,7 @@ namespace online
 	class SocialConnection
 	{
 		friend class SocialService;
+		friend class SocialGraph;
         
     public:
     
@@ -64,6 +65,7 @@ namespace online
 		};
 
 		friend class SocialService;
+		friend class SocialGraph;
     
     public:
         SocialRequest(const Json::Value& data);
@@ -5,6 +5,7 @@
 #include "anthill/services/Service.h"
 #include "anthill/requests/Request.h"
 #include "anthill/ApplicationInfo.h"
+#include "anthill/StoreCatalog.h"
 #include <json/value.h>
 
 #include <set>
@@ -161,6 +162,11 @@ namespace online
     public:
         typedef std::function< void(const StoreService& service, Request::Result result, const Request& request,
                                     const StorePtr& store) > GetStoreCallback;
+
+        // 'cached' is true for the catalog from the last time, the callback is called again once
+        // the one from the server is there, if it's any different
+        typedef std::function< void(const StoreService& service, Request::Result result, const Request& request,
+                                    const StoreCatalogPtr& catalog, bool cached) > GetCatalogCallback;
         
     public:
         static const std::string ID;
@@ -172,11 +178,27 @@ namespace online
         
         void getStore(const std::string& name, const std::string& accessToken, GetStoreCallback callback);
 
+        // the same store as an indexed StoreCatalog, kept in the storage between the runs
+        void getCatalog(const std::string& name, const std::string& accessToken, GetCatalogCallback callback);
+
     protected:
         StoreService(const std::string& location);
         bool init();
         
     private:
+        // a response for the callbacks served from the cache
+        const Request& getCachedRequest();
+
+    private:
+        struct CachedCatalog
+        {
+            StoreCatalogPtr catalog;
+            // the response it's been built from
+            std::string data;
+        };
+
+        std::unordered_map<std::string, CachedCatalog> m_catalogs;
+        RequestPtr m_cachedRequest;
     };
 };
 
@@ -2,6 +2,8 @@
 #ifndef ONLINE_StateMachine_H
 #define ONLINE_StateMachine_H
 
+#include "anthill/Tracing.h"
+
 #include <functional>
 #include <memory>
 #include <string>
@@ -59,6 +61,7 @@ namespace online
 		CompleteCallback m_completeCallback;
 		std::string m_name;
         bool m_locked;
+        Tracer::SpanId m_stateSpan;
 	};
 };
 
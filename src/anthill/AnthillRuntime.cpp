@@ -1,7 +1,13 @@
 
 #include "anthill/AnthillRuntime.h"
+#include "anthill/Websockets.h"
+#include "anthill/TokenManager.h"
+#include "anthill/ScoreQueue.h"
 #include "anthill/Utils.h"
+#include "anthill/Log.h"
 #include <algorithm>
+#include <cstdlib>
+#include <mutex>
 
 #include "anthill/services/EnvironmentService.h"
 #include "anthill/services/DiscoveryService.h"
@@ -20,6 +26,67 @@
 
 namespace online
 {
+	// the runtime bound to the thread, and whether it's still there: a runtime may be destroyed
+	// by another thread than the ones it has been bound to
+	struct Binding
+	{
+		Binding() :
+			runtime(nullptr)
+		{}
+
+		AnthillRuntime* runtime;
+		std::shared_ptr<const std::atomic<bool>> alive;
+	};
+
+	static thread_local Binding s_current;
+
+	AnthillRuntime& AnthillRuntime::Instance()
+	{
+		AnthillRuntime* runtime = InstancePtr();
+
+		if (runtime == nullptr)
+		{
+			// OnlineAssert does nothing in the release builds, and a null reference would crash further away
+			Log::get(Log::LEVEL_ERROR) << "No runtime is bound to this thread." << std::endl;
+			Log::flush();
+			std::abort();
+		}
+
+		return *runtime;
+	}
+
+	AnthillRuntime* AnthillRuntime::InstancePtr()
+	{
+		if (s_current.runtime == nullptr || !s_current.alive || !s_current.alive->load())
+			return nullptr;
+
+		return s_current.runtime;
+	}
+
+	bool AnthillRuntime::IsInstanceValid()
+	{
+		return InstancePtr() != nullptr;
+	}
+
+	AnthillRuntime::Scope::Scope(AnthillRuntime& runtime) :
+		m_previous(s_current.runtime),
+		m_previousAlive(s_current.alive)
+	{
+		runtime.bind();
+	}
+
+	AnthillRuntime::Scope::~Scope()
+	{
+		s_current.runtime = m_previous;
+		s_current.alive = m_previousAlive;
+	}
+
+	void AnthillRuntime::bind()
+	{
+		s_current.runtime = this;
+		s_current.alive = m_alive;
+	}
+
 	AnthillRuntimePtr AnthillRuntime::Create(
 		const std::string& environment, 
 		const std::set<std::string>& enabledServices, 
@@ -27,6 +94,10 @@ namespace online
         ListenerPtr listener,
 		const ApplicationInfo& applicationInfo)
 	{
+		// curl initializes itself lazily otherwise, which is not safe with runtimes created on several threads
+		static std::once_flag curlInitialized;
+		std::call_once(curlInitialized, []() { curl_global_init(CURL_GLOBAL_ALL); });
+
 		return AnthillRuntimePtr(new AnthillRuntime(environment, enabledServices, storage, listener, applicationInfo));
 	}
 
@@ -43,12 +114,19 @@ namespace online
         ListenerPtr listener,
 		const ApplicationInfo& applicationInfo) :
 
+		m_alive(std::make_shared<std::atomic<bool>>(true)),
 		m_transport(),
+		m_websocketHub(WebsocketHub::Create()),
+		m_ownsWebsocketHub(true),
+		m_tokenManager(TokenManager::Create()),
+		m_scoreQueue(ScoreQueue::Create()),
 		m_applicationInfo(applicationInfo),
         m_storage(storage),
         m_listener(listener),
         m_enabledServices(enabledServices)
 	{
+		bind();
+
         Register<EnvironmentService>();
         Register<DiscoveryService>();
         Register<LoginService>();
@@ -69,7 +147,22 @@ namespace online
 
 	AnthillRuntime::~AnthillRuntime()
 	{
-		//
+		{
+			// the services and the requests may still look for their runtime while released
+			Scope scope(*this);
+
+			m_requests.clear();
+			m_services.clear();
+			m_futures.clear();
+		}
+
+		// every thread it's still bound to sees it's gone
+		m_alive->store(false);
+
+		if (s_current.runtime == this)
+		{
+			s_current = Binding();
+		}
 	}
 
 	const StoragePtr& AnthillRuntime::getStorage() const
@@ -82,6 +175,35 @@ namespace online
         return m_listener;
     }
 
+	const WebsocketHubPtr& AnthillRuntime::getWebsocketHub() const
+	{
+		return m_websocketHub;
+	}
+
+	const TokenManagerPtr& AnthillRuntime::getTokenManager() const
+	{
+		return m_tokenManager;
+	}
+
+	const ScoreQueuePtr& AnthillRuntime::getScoreQueue() const
+	{
+		return m_scoreQueue;
+	}
+
+	void AnthillRuntime::setWebsocketHub(const WebsocketHubPtr& hub)
+	{
+		m_websocketHub = hub;
+		m_ownsWebsocketHub = false;
+	}
+
+	void AnthillRuntime::requestCompleted(const Request& request, float duration)
+	{
+		if (m_requestObserver)
+		{
+			m_requestObserver(request, duration);
+		}
+	}
+
 	Futures& AnthillRuntime::getFutures()
 	{
 		return m_futures;
@@ -94,6 +216,8 @@ namespace online
 
 	void AnthillRuntime::update(float dt)
 	{
+		Scope scope(*this);
+
         while (!m_transport.perform());
         
         curl::curl_easy* next;
@@ -111,7 +235,14 @@ namespace online
             }
         }
         
-		m_futures.update(dt);
+        if (m_ownsWebsocketHub)
+        {
+            m_websocketHub->update();
+        }
+        m_tokenManager->update();
+        m_scoreQueue->update();
+        
+		m_futures.update();
         
         for (const std::unordered_map<std::string, ServicePtr>::value_type& entry: m_services)
         {
@@ -0,0 +1,612 @@
+
+#include "anthill/BundleManager.h"
+#include "anthill/AnthillRuntime.h"
+#include "anthill/Hash.h"
+#include "anthill/Log.h"
+#include "anthill/Utils.h"
+
+#include "curl_ios.h"
+
+#include <json/reader.h>
+#include <json/writer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#if defined( WIN32 ) || defined( _WIN32 )
+	#include <Windows.h>
+#endif
+
+namespace online
+{
+	// Streams the bundle into a file and hashes it on the way
+	class BundleDownloadRequest : public Request
+	{
+	public:
+		typedef std::function< void(const BundleDownloadRequest&) > ResponseCallback;
+		typedef std::function< void() > DataCallback;
+
+	public:
+		static BundleDownloadRequestPtr Create(const std::string& location, const std::string& path, long size)
+		{
+			BundleDownloadRequestPtr _object(new BundleDownloadRequest(location, path, size));
+			if (!_object->init())
+				return BundleDownloadRequestPtr(nullptr);
+
+			return _object;
+		}
+
+		virtual std::string getResponseAsString() const override
+		{
+			return "";
+		}
+
+		void setOnResponse(ResponseCallback onResponse) { m_onResponse = onResponse; }
+		void setOnData(DataCallback onData) { m_onData = onData; }
+
+		const std::string& getPath() const { return m_path; }
+		long getDownloaded() const { return m_downloaded; }
+		// the file could not be written, or there has been more data than expected
+		bool isBroken() const { return m_broken; }
+
+		std::string getSHA256() const { return m_sha256.hex(); }
+		const CRC32& getCRC32() const { return m_crc32; }
+
+		// cancels it and removes what's been downloaded so far
+		void discard()
+		{
+			cancel();
+
+			m_file.close();
+			std::remove(m_path.c_str());
+		}
+
+	protected:
+		BundleDownloadRequest(const std::string& location, const std::string& path, long size) :
+			Request(location, METHOD_GET, curl::curl_ios<std::ofstream>(m_file)),
+			m_path(path),
+			m_size(size),
+			m_downloaded(0),
+			m_broken(false)
+		{
+			getTransport().add<CURLOPT_WRITEFUNCTION>(&BundleDownloadRequest::write);
+			getTransport().add<CURLOPT_WRITEDATA>(static_cast<void*>(this));
+		}
+
+		virtual bool init() override
+		{
+			m_file.open(m_path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+			if (!m_file.good())
+			{
+				Log::get() << "Failed to open " << m_path << std::endl;
+				return false;
+			}
+
+			return Request::init();
+		}
+
+		virtual void connectionError() override
+		{
+			Log::get() << "BundleDownloadRequest(" << m_path << "): <Connection Error>" << std::endl;
+		}
+
+		virtual void complete() override
+		{
+			m_file.close();
+
+			Request::complete();
+
+			if (m_onResponse)
+			{
+				Tracer::Scope scope(getSpan());
+				m_onResponse(*this);
+			}
+		}
+
+	private:
+		static size_t write(void* data, size_t size, size_t count, void* userdata)
+		{
+			BundleDownloadRequest* request = static_cast<BundleDownloadRequest*>(userdata);
+			size_t length = size * count;
+
+			// anything but the full length aborts the transfer
+			if (request->isCancelled())
+				return 0;
+
+			if (request->m_size > 0 && request->m_downloaded + (long)length > request->m_size)
+			{
+				request->m_broken = true;
+				return 0;
+			}
+
+			request->m_file.write(static_cast<const char*>(data), length);
+
+			if (!request->m_file.good())
+			{
+				request->m_broken = true;
+				return 0;
+			}
+
+			request->m_sha256.update(data, length);
+			request->m_crc32.update(data, length);
+			request->m_downloaded += (long)length;
+
+			if (request->m_onData)
+			{
+				request->m_onData();
+			}
+
+			return length;
+		}
+
+	private:
+		std::ofstream m_file;
+		std::string m_path;
+		long m_size;
+		long m_downloaded;
+		bool m_broken;
+
+		mutable SHA256 m_sha256;
+		CRC32 m_crc32;
+
+		ResponseCallback m_onResponse;
+		DataCallback m_onData;
+	};
+
+	static bool equalHex(const std::string& a, const std::string& b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+		{
+			return ::tolower((unsigned char)x) == ::tolower((unsigned char)y);
+		});
+	}
+
+	BundleManagerPtr BundleManager::Create(const std::string& directory)
+	{
+		BundleManagerPtr _object(new BundleManager(directory));
+		if (!_object->init())
+			return BundleManagerPtr(nullptr);
+
+		return _object;
+	}
+
+	BundleManager::BundleManager(const std::string& directory) :
+		m_directory(directory),
+		m_installed(Json::objectValue),
+		m_completed(0),
+		m_progressPosted(false),
+		m_updating(false)
+	{
+		//
+	}
+
+	bool BundleManager::init()
+	{
+		load();
+		return true;
+	}
+
+	std::string BundleManager::getPath(const std::string& name) const
+	{
+		if (m_directory.empty())
+			return name;
+
+		char last = m_directory[m_directory.size() - 1];
+
+		if (last == '/' || last == '\\')
+			return m_directory + name;
+
+		return m_directory + "/" + name;
+	}
+
+	bool BundleManager::isInstalled(const DLCService::Bundle& bundle) const
+	{
+		const Json::Value& installed = m_installed[bundle.getName()];
+
+		if (!installed.isObject())
+			return false;
+
+		if (!equalHex(installed["hash"].asString(), bundle.getSHA256()) ||
+			!equalHex(installed["crc32"].asString(), bundle.getCRC32()) ||
+			installed["size"].asLargestInt() != bundle.getSize())
+		{
+			return false;
+		}
+
+		// the file might have been removed since
+		return std::ifstream(getPath(bundle.getName()).c_str()).good();
+	}
+
+	DLCService::Bundles BundleManager::getMissing(const DLCService::Bundles& bundles) const
+	{
+		DLCService::Bundles missing;
+
+		for (const DLCService::Bundle& bundle : bundles)
+		{
+			if (!isInstalled(bundle))
+			{
+				missing.push_back(bundle);
+			}
+		}
+
+		return missing;
+	}
+
+	void BundleManager::update(const DLCService::Bundles& bundles, ProgressCallback onProgress, UpdateCallback onUpdated)
+	{
+		OnlineAssert(!m_updating, "The bundles are being updated already.");
+
+		m_onProgress = onProgress;
+		m_onUpdated = onUpdated;
+		m_failed.clear();
+		m_progress = Progress();
+		m_completed = 0;
+		m_updating = true;
+
+		for (const DLCService::Bundle& bundle : getMissing(bundles))
+		{
+			m_queue.push_back(Download(bundle));
+			m_progress.total += std::max(bundle.getSize(), 0L);
+			m_progress.bundles++;
+		}
+
+		if (m_queue.empty())
+		{
+			postFinish();
+			return;
+		}
+
+		Log::get() << "Updating " << m_progress.bundles << " bundle(s), " << m_progress.total << " bytes" << std::endl;
+
+		next();
+	}
+
+	void BundleManager::next()
+	{
+		long inFlight = 0;
+
+		for (const Download& download : m_active)
+		{
+			inFlight += download.bundle.getSize();
+		}
+
+		Downloads::iterator it = m_queue.begin();
+
+		while (it != m_queue.end() && m_active.size() < m_policy.maxDownloads)
+		{
+			long size = it->bundle.getSize();
+
+			// a smaller bundle further down the queue might fit in
+			if (!m_active.empty() && inFlight + size > m_policy.maxBytesInFlight)
+			{
+				it++;
+				continue;
+			}
+
+			Downloads::iterator download = it++;
+			m_active.splice(m_active.end(), m_queue, download);
+
+			if (start(*download))
+			{
+				inFlight += size;
+			}
+			else
+			{
+				failed(*download);
+				m_active.erase(download);
+			}
+		}
+
+		if (m_active.empty() && m_queue.empty())
+		{
+			postFinish();
+		}
+	}
+
+	bool BundleManager::start(Download& download)
+	{
+		download.attempt++;
+
+		BundleDownloadRequestPtr request = BundleDownloadRequest::Create(
+			download.bundle.getUrl(), getPath(download.bundle.getName()) + ".part", download.bundle.getSize());
+
+		if (!request)
+			return false;
+
+		std::weak_ptr<BundleManager> weak = shared_from_this();
+
+		request->setName("bundle");
+		request->setFollowRedirects(true);
+		// a bundle takes as long as it takes, as long as the data keeps coming
+		request->setTimeout(0);
+		request->getTransport().add<CURLOPT_LOW_SPEED_LIMIT>(1L);
+		request->getTransport().add<CURLOPT_LOW_SPEED_TIME>(m_policy.stallTimeout);
+
+		request->setOnData([weak]()
+		{
+			if (BundleManagerPtr manager = weak.lock())
+			{
+				manager->postProgress();
+			}
+		});
+
+		request->setOnResponse([weak](const BundleDownloadRequest& request)
+		{
+			BundleManagerPtr manager = weak.lock();
+
+			if (manager)
+			{
+				manager->downloaded(request);
+			}
+			else
+			{
+				std::remove(request.getPath().c_str());
+			}
+		});
+
+		download.request = request;
+		request->start();
+
+		return true;
+	}
+
+	void BundleManager::downloaded(const BundleDownloadRequest& request)
+	{
+		Downloads::iterator it = std::find_if(m_active.begin(), m_active.end(), [&request](const Download& download)
+		{
+			return download.request.get() == &request;
+		});
+
+		// cancelled, the same bundle might be downloaded again already
+		if (it == m_active.end())
+		{
+			bool reused = std::any_of(m_active.begin(), m_active.end(), [&request](const Download& download)
+			{
+				return download.request && download.request->getPath() == request.getPath();
+			});
+
+			if (!reused)
+			{
+				std::remove(request.getPath().c_str());
+			}
+
+			return;
+		}
+
+		Download& download = *it;
+
+		if (request.isSuccessful() && !request.isBroken() && verify(download) && install(download))
+		{
+			m_completed += request.getDownloaded();
+			m_progress.installed++;
+		}
+		else
+		{
+			std::remove(request.getPath().c_str());
+
+			if (download.attempt <= m_policy.retries)
+			{
+				Log::get() << "Bundle " << download.bundle.getName() << " failed, retrying" << std::endl;
+
+				download.request.reset();
+				m_queue.splice(m_queue.begin(), m_active, it);
+			}
+			else
+			{
+				failed(download);
+				m_active.erase(it);
+			}
+		}
+
+		reportProgress();
+
+		if (m_updating)
+		{
+			next();
+		}
+	}
+
+	bool BundleManager::verify(const Download& download) const
+	{
+		const DLCService::Bundle& bundle = download.bundle;
+		const BundleDownloadRequest& request = *download.request;
+
+		if (bundle.getSize() > 0 && request.getDownloaded() != bundle.getSize())
+		{
+			Log::get() << "Bundle " << bundle.getName() << ": expected " << bundle.getSize() <<
+				" bytes, got " << request.getDownloaded() << std::endl;
+			return false;
+		}
+
+		if (!bundle.getSHA256().empty() && !equalHex(request.getSHA256(), bundle.getSHA256()))
+		{
+			Log::get() << "Bundle " << bundle.getName() << ": SHA-256 mismatch" << std::endl;
+			return false;
+		}
+
+		// the leading zeroes may be omitted
+		if (!bundle.getCRC32().empty() &&
+			strtoul(bundle.getCRC32().c_str(), nullptr, 16) != request.getCRC32().get())
+		{
+			Log::get() << "Bundle " << bundle.getName() << ": CRC32 mismatch" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool BundleManager::install(const Download& download)
+	{
+		const DLCService::Bundle& bundle = download.bundle;
+		std::string path = getPath(bundle.getName());
+
+#if defined( WIN32 ) || defined( _WIN32 )
+		// rename does not replace an existing file there
+		bool moved = MoveFileExA(download.request->getPath().c_str(), path.c_str(),
+			MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		bool moved = std::rename(download.request->getPath().c_str(), path.c_str()) == 0;
+#endif
+
+		if (!moved)
+		{
+			Log::get() << "Failed to install bundle " << bundle.getName() << std::endl;
+			return false;
+		}
+
+		Json::Value& installed = m_installed[bundle.getName()];
+
+		installed["hash"] = bundle.getSHA256();
+		installed["crc32"] = bundle.getCRC32();
+		installed["size"] = (Json::LargestInt)bundle.getSize();
+
+		save();
+
+		Log::get() << "Bundle " << bundle.getName() << " installed" << std::endl;
+		return true;
+	}
+
+	void BundleManager::failed(Download& download)
+	{
+		Log::get() << "Bundle " << download.bundle.getName() << " could not be installed" << std::endl;
+		m_failed.insert(download.bundle.getName());
+	}
+
+	void BundleManager::postProgress()
+	{
+		if (m_progressPosted || !m_onProgress)
+			return;
+
+		m_progressPosted = true;
+
+		std::weak_ptr<BundleManager> weak = shared_from_this();
+
+		// the data comes in many small pieces, the progress is reported once per update at most
+		AnthillRuntime::Instance().getFutures().postNextUpdate([weak]()
+		{
+			if (BundleManagerPtr manager = weak.lock())
+			{
+				manager->m_progressPosted = false;
+
+				if (manager->m_updating)
+				{
+					manager->reportProgress();
+				}
+			}
+		});
+	}
+
+	void BundleManager::reportProgress()
+	{
+		m_progress.downloaded = m_completed;
+
+		for (const Download& download : m_active)
+		{
+			if (download.request)
+			{
+				m_progress.downloaded += download.request->getDownloaded();
+			}
+		}
+
+		if (m_onProgress)
+		{
+			m_onProgress(m_progress);
+		}
+	}
+
+	void BundleManager::postFinish()
+	{
+		std::weak_ptr<BundleManager> weak = shared_from_this();
+
+		// same as the rest of the callbacks, not from within update
+		AnthillRuntime::Instance().getFutures().postNextUpdate([weak]()
+		{
+			if (BundleManagerPtr manager = weak.lock())
+			{
+				// the last ones might have been retried meanwhile, or the update cancelled
+				if (manager->m_updating && manager->m_active.empty() && manager->m_queue.empty())
+				{
+					manager->finish();
+				}
+			}
+		});
+	}
+
+	void BundleManager::finish()
+	{
+		m_updating = false;
+
+		UpdateCallback onUpdated = m_onUpdated;
+
+		m_onProgress = nullptr;
+		m_onUpdated = nullptr;
+
+		if (onUpdated)
+		{
+			onUpdated(m_failed.empty(), m_failed);
+		}
+	}
+
+	void BundleManager::cancel()
+	{
+		for (Download& download : m_active)
+		{
+			if (download.request)
+			{
+				download.request->discard();
+			}
+		}
+
+		m_active.clear();
+		m_queue.clear();
+		m_updating = false;
+		m_onProgress = nullptr;
+		m_onUpdated = nullptr;
+	}
+
+	void BundleManager::load()
+	{
+		if (!AnthillRuntime::IsInstanceValid())
+			return;
+
+		const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+
+		if (!storage || !storage->has(Storage::StorageBundlesField))
+			return;
+
+		Json::Value installed;
+
+		if (Json::Reader().parse(storage->get(Storage::StorageBundlesField), installed) && installed.isObject())
+		{
+			m_installed = installed;
+		}
+	}
+
+	void BundleManager::save()
+	{
+		if (!AnthillRuntime::IsInstanceValid())
+			return;
+
+		const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+
+		if (!storage)
+			return;
+
+		storage->set(Storage::StorageBundlesField, Json::FastWriter().write(m_installed));
+		storage->save();
+	}
+
+	BundleManager::~BundleManager()
+	{
+		for (Download& download : m_active)
+		{
+			if (download.request)
+			{
+				download.request->discard();
+			}
+		}
+	}
+}
@@ -0,0 +1,215 @@
+#include "anthill/EventCache.h"
+#include "anthill/AnthillRuntime.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace online
+{
+	// seconds to wait after a failed fetch, doubled with every failure in a row
+	static const float RETRY_INTERVAL = 5.0f;
+	static const float MAX_RETRY_INTERVAL = 300.0f;
+
+	EventCachePtr EventCache::Create(const EventServicePtr& service, const std::string& accessToken,
+		int extraStartTime, int extraEndTime)
+	{
+		EventCachePtr _object(new EventCache(service, accessToken, extraStartTime, extraEndTime));
+		if (!_object->init())
+			return EventCachePtr(nullptr);
+
+		return _object;
+	}
+
+	EventCache::EventCache(const EventServicePtr& service, const std::string& accessToken,
+		int extraStartTime, int extraEndTime) :
+		m_service(service),
+		m_accessToken(accessToken),
+		m_extraStartTime(extraStartTime),
+		m_extraEndTime(extraEndTime),
+		m_synced(false),
+		m_fetching(false),
+		m_refreshFuture(0),
+		m_retryInterval(0)
+	{
+		//
+	}
+
+	bool EventCache::init()
+	{
+		return !m_service.expired();
+	}
+
+	EventPtr EventCache::getEvent(const std::string& id) const
+	{
+		EventService::Events::const_iterator it = m_events.find(id);
+		return it != m_events.end() ? it->second : EventPtr();
+	}
+
+	void EventCache::sync(Callback callback)
+	{
+		if (m_synced && !m_fetching)
+		{
+			callback(*this, Request::SUCCESS);
+			return;
+		}
+
+		refresh(callback);
+	}
+
+	void EventCache::refresh(Callback callback)
+	{
+		if (callback)
+		{
+			m_callbacks.push_back(callback);
+		}
+
+		if (m_fetching)
+			return;
+
+		EventServicePtr service = m_service.lock();
+
+		if (!service)
+		{
+			EventService::Events none;
+			fetched(Request::CLIENT_ERROR, none);
+			return;
+		}
+
+		m_fetching = true;
+
+		std::weak_ptr<EventCache> weak = shared_from_this();
+
+		service->getEvents(m_accessToken, [weak](const EventService& service, Request::Result result,
+			const Request& request, EventService::Events& events)
+		{
+			EventCachePtr self = weak.lock();
+
+			if (self)
+			{
+				self->fetched(result, events);
+			}
+		}, m_extraStartTime, m_extraEndTime);
+	}
+
+	void EventCache::fetched(Request::Result result, EventService::Events& events)
+	{
+		m_fetching = false;
+
+		if (Request::isSuccessful(result))
+		{
+			m_events.swap(events);
+			m_synced = true;
+			m_retryInterval = 0;
+
+			scheduleRefresh();
+
+			if (m_onChanged)
+			{
+				m_onChanged(*this);
+			}
+		}
+		// a service that is gone won't come back
+		else if (!m_service.expired())
+		{
+			scheduleRetry();
+		}
+
+		std::vector<Callback> callbacks;
+		callbacks.swap(m_callbacks);
+
+		for (const Callback& callback: callbacks)
+		{
+			callback(*this, result);
+		}
+	}
+
+	void EventCache::scheduleRefresh()
+	{
+		if (!AnthillRuntime::IsInstanceValid())
+			return;
+
+		Futures& futures = AnthillRuntime::Instance().getFutures();
+
+		if (m_refreshFuture)
+		{
+			futures.cancel(m_refreshFuture);
+			m_refreshFuture = 0;
+		}
+
+		// the closest start or end of an event, the state of the events changes only then
+		Event::EventTime closest = std::numeric_limits<Event::EventTime>::max();
+
+		for (const EventService::Events::value_type& entry: m_events)
+		{
+			const Event& event = *entry.second;
+
+			if (!event.isEnabled())
+				continue;
+
+			Event::EventTime now = event.getServerTime();
+			Event::EventTime left = 0;
+
+			if (event.getTimeStart() > now)
+				left = event.getTimeStart() - now;
+			else if (event.getTimeEnd() > now)
+				left = event.getTimeEnd() - now;
+			else
+				continue;
+
+			closest = std::min(closest, left);
+		}
+
+		if (closest == std::numeric_limits<Event::EventTime>::max())
+			return;
+
+		std::weak_ptr<EventCache> weak = shared_from_this();
+
+		// a bit later, so the server has surely moved on as well
+		m_refreshFuture = futures.add((float)closest + 1.0f, [weak]()
+		{
+			EventCachePtr self = weak.lock();
+
+			if (self)
+			{
+				self->m_refreshFuture = 0;
+				self->refresh();
+			}
+		});
+	}
+
+	void EventCache::scheduleRetry()
+	{
+		if (!AnthillRuntime::IsInstanceValid())
+			return;
+
+		Futures& futures = AnthillRuntime::Instance().getFutures();
+
+		if (m_refreshFuture)
+		{
+			futures.cancel(m_refreshFuture);
+		}
+
+		m_retryInterval = m_retryInterval > 0 ? std::min(m_retryInterval * 2, MAX_RETRY_INTERVAL) : RETRY_INTERVAL;
+
+		std::weak_ptr<EventCache> weak = shared_from_this();
+
+		m_refreshFuture = futures.add(m_retryInterval, [weak]()
+		{
+			EventCachePtr self = weak.lock();
+
+			if (self)
+			{
+				self->m_refreshFuture = 0;
+				self->refresh();
+			}
+		});
+	}
+
+	EventCache::~EventCache()
+	{
+		if (m_refreshFuture && AnthillRuntime::IsInstanceValid())
+		{
+			AnthillRuntime::Instance().getFutures().cancel(m_refreshFuture);
+		}
+	}
+}
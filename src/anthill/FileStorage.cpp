@@ -0,0 +1,345 @@
+#include "anthill/FileStorage.h"
+#include "anthill/Log.h"
+
+#include <json/reader.h>
+#include <json/writer.h>
+
+#include <cstdio>
+
+namespace online
+{
+	FileStoragePtr FileStorage::Create(const std::string& path, int compactAfter)
+	{
+		FileStoragePtr _object(new FileStorage(path, compactAfter));
+		if (!_object->init())
+			return FileStoragePtr(nullptr);
+
+		return _object;
+	}
+
+	FileStorage::FileStorage(const std::string& path, int compactAfter) :
+		m_path(path),
+		m_compactAfter(compactAfter),
+		m_queued(0),
+		m_done(0),
+		m_stopping(false),
+		m_failed(false),
+		m_journalRecords(0),
+		m_journalTorn(false)
+	{
+		//
+	}
+
+	bool FileStorage::init()
+	{
+		load();
+
+		m_thread = std::thread(&FileStorage::run, this);
+		return true;
+	}
+
+	void FileStorage::Batch::set(const std::string& key, const std::string& value)
+	{
+		m_set[key] = value;
+		m_remove.erase(key);
+	}
+
+	void FileStorage::Batch::remove(const std::string& key)
+	{
+		m_set.erase(key);
+		m_remove.insert(key);
+	}
+
+	void FileStorage::Batch::merge(const Batch& other)
+	{
+		for (const std::string& key : other.m_remove)
+		{
+			remove(key);
+		}
+
+		for (const Values::value_type& entry : other.m_set)
+		{
+			set(entry.first, entry.second);
+		}
+	}
+
+	void FileStorage::Batch::apply(Values& values) const
+	{
+		for (const std::string& key : m_remove)
+		{
+			values.erase(key);
+		}
+
+		for (const Values::value_type& entry : m_set)
+		{
+			values[entry.first] = entry.second;
+		}
+	}
+
+	void FileStorage::load()
+	{
+		std::string tmp = m_path + ".tmp";
+
+		// the compaction has been interrupted between removing the file and moving the new one over it
+		if (!std::ifstream(m_path.c_str()).good() && std::ifstream(tmp.c_str()).good())
+		{
+			std::rename(tmp.c_str(), m_path.c_str());
+		}
+
+		Json::Reader reader;
+
+		{
+			std::ifstream file(m_path.c_str());
+			Json::Value values;
+
+			if (file.good() && reader.parse(file, values) && values.isObject())
+			{
+				for (Json::ValueConstIterator it = values.begin(); it != values.end(); it++)
+				{
+					m_values[it.name()] = it->asString();
+				}
+			}
+		}
+
+		std::ifstream journal((m_path + ".journal").c_str(), std::ios::in | std::ios::binary);
+		std::string line;
+
+		while (std::getline(journal, line))
+		{
+			Json::Value record;
+
+			// a torn write, nothing after it has made it to the disk.
+			// A line without the new line at the end is torn too, even if it parses
+			if (journal.eof() || !reader.parse(line, record) || !record.isObject())
+			{
+				m_journalTorn = true;
+				break;
+			}
+
+			Batch batch;
+
+			for (const Json::Value& key : record["remove"])
+			{
+				batch.remove(key.asString());
+			}
+
+			const Json::Value& set = record["set"];
+
+			for (Json::ValueConstIterator it = set.begin(); it != set.end(); it++)
+			{
+				batch.set(it.name(), it->asString());
+			}
+
+			batch.apply(m_values);
+			m_journalRecords++;
+		}
+
+		m_persisted = m_values;
+	}
+
+	void FileStorage::set(const std::string& key, const std::string& value)
+	{
+		m_values[key] = value;
+		m_pending.set(key, value);
+	}
+
+	std::string FileStorage::get(const std::string& key) const
+	{
+		Values::const_iterator it = m_values.find(key);
+
+		if (it == m_values.end())
+			return "";
+
+		return it->second;
+	}
+
+	bool FileStorage::has(const std::string& key) const
+	{
+		return m_values.find(key) != m_values.end();
+	}
+
+	void FileStorage::remove(const std::string& key)
+	{
+		if (m_values.erase(key))
+		{
+			m_pending.remove(key);
+		}
+	}
+
+	void FileStorage::save()
+	{
+		if (m_failed.exchange(false))
+		{
+			Log::get() << "FileStorage: failed to write " << m_path << std::endl;
+		}
+
+		if (m_pending.empty())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_queue.push_back(Batch());
+			m_queue.back().m_set.swap(m_pending.m_set);
+			m_queue.back().m_remove.swap(m_pending.m_remove);
+			m_queued++;
+		}
+
+		m_wakeUp.notify_one();
+	}
+
+	void FileStorage::flush()
+	{
+		save();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		unsigned int queued = m_queued;
+
+		m_written.wait(lock, [this, queued]() { return m_done >= queued; });
+	}
+
+	void FileStorage::run()
+	{
+		// a journal left from the previous run (even a torn record alone) is folded into the file first,
+		// so the new records are not appended to partial bytes
+		if (m_journalRecords > 0 || m_journalTorn)
+		{
+			compact();
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (true)
+		{
+			m_wakeUp.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+
+			std::list<Batch> batches;
+			batches.swap(m_queue);
+
+			lock.unlock();
+
+			if (!batches.empty())
+			{
+				// whatever has piled up meanwhile goes in as one record
+				Batch batch;
+
+				for (const Batch& other : batches)
+				{
+					batch.merge(other);
+				}
+
+				batch.apply(m_persisted);
+
+				// nothing is appended after torn bytes, the next load would drop it; the file
+				// gets the batch along with everything else instead, until a compaction works
+				if (m_journalTorn || !write(batch) || m_journalRecords >= m_compactAfter)
+				{
+					compact();
+				}
+			}
+
+			lock.lock();
+
+			m_done += (unsigned int)batches.size();
+			m_written.notify_all();
+
+			if (m_stopping && m_queue.empty())
+				break;
+		}
+	}
+
+	bool FileStorage::write(const Batch& batch)
+	{
+		if (!m_journal.is_open())
+		{
+			m_journal.open((m_path + ".journal").c_str(), std::ios::out | std::ios::app | std::ios::binary);
+		}
+
+		Json::Value record(Json::objectValue);
+		Json::Value& set = record["set"] = Json::Value(Json::objectValue);
+		Json::Value& remove = record["remove"] = Json::Value(Json::arrayValue);
+
+		for (const Values::value_type& entry : batch.m_set)
+		{
+			set[entry.first] = entry.second;
+		}
+
+		for (const std::string& key : batch.m_remove)
+		{
+			remove.append(key);
+		}
+
+		// FastWriter ends the record with a new line
+		m_journal << Json::FastWriter().write(record);
+		m_journal.flush();
+
+		if (!m_journal.good())
+		{
+			// part of the record might have made it
+			m_journal.close();
+			m_journalTorn = true;
+			return false;
+		}
+
+		m_journalRecords++;
+		return true;
+	}
+
+	bool FileStorage::compact()
+	{
+		std::string tmp = m_path + ".tmp";
+
+		{
+			Json::Value values(Json::objectValue);
+
+			for (const Values::value_type& entry : m_persisted)
+			{
+				values[entry.first] = entry.second;
+			}
+
+			std::ofstream file(tmp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+			file << Json::FastWriter().write(values);
+			file.flush();
+
+			if (!file.good())
+			{
+				m_failed = true;
+				return false;
+			}
+		}
+
+#if defined( WIN32 ) || defined( _WIN32 )
+		// rename does not replace an existing file there
+		std::remove(m_path.c_str());
+#endif
+
+		if (std::rename(tmp.c_str(), m_path.c_str()) != 0)
+		{
+			m_failed = true;
+			return false;
+		}
+
+		// everything in the journal is in the file now
+		m_journal.close();
+		m_journal.open((m_path + ".journal").c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		m_journalRecords = 0;
+		m_journalTorn = false;
+
+		return true;
+	}
+
+	FileStorage::~FileStorage()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+
+		m_wakeUp.notify_one();
+
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+}
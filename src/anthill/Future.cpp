@@ -7,51 +7,39 @@ namespace online
     const int Future::REPEAT_FOREVER = -1;
 
 	Future::Future(float time, Callback callback, int repeat) :
-			m_time(time),
-            m_original(time),
+			m_period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(time))),
 			m_callback(callback),
             m_repeat(repeat)
 	{
 		//
 	}
 
-	bool Future::update(float dt)
-	{
-		m_time -= dt;
-		if (m_time <= 0)
-		{
-			m_callback();
-            if (m_repeat)
-            {
-                m_time = m_original;
-                
-                if (m_repeat < 0)
-                    return false;
-                
-                m_repeat--;
-                return m_repeat > 0;
-            }
-            
-			return true;
-		}
-
-		return false;
-	}
-    
     void Futures::cancel(int futureId)
     {
+        // the deadline stays in the heap, and is skipped once it comes up or dropped by the next compaction
         m_futures.erase(futureId);
     }
 
 	int Futures::add(float time, Future::Callback callback, int repeat)
 	{
         int id = m_nextId++;
-    
-        m_futures.emplace(
+
+        std::unordered_map<int, Future>::iterator it = m_futures.emplace(
             std::piecewise_construct,
             std::forward_as_tuple(id),
-            std::forward_as_tuple(time, callback, repeat));
-    
+            std::forward_as_tuple(time, callback, repeat)).first;
+
+        Deadline deadline(Future::Clock::now() + it->second.m_period, id);
+
+        if (m_updating)
+        {
+            m_scheduled.push_back(deadline);
+        }
+        else
+        {
+            m_deadlines.push(deadline);
+        }
+
         return id;
 	}
 
@@ -59,35 +47,106 @@ namespace online
 	{
 		m_nextUpdate.push_back(callback);
 	}
-	
+
     void Futures::clear()
     {
         m_nextUpdate.clear();
         m_futures.clear();
+        m_scheduled.clear();
+        m_deadlines.clear();
+    }
+
+    void Futures::dropCancelled()
+    {
+        while (!m_deadlines.empty() && m_futures.find(m_deadlines.top().m_id) == m_futures.end())
+        {
+            m_deadlines.pop();
+        }
+    }
+
+    float Futures::getTimeToNext()
+    {
+        if (!m_nextUpdate.empty())
+            return 0;
+
+        dropCancelled();
+
+        if (m_deadlines.empty())
+            return -1.0f;
+
+        float left = std::chrono::duration<float>(m_deadlines.top().m_when - Future::Clock::now()).count();
+        return std::max(left, 0.0f);
     }
 
-	void Futures::update(float dt)
+	void Futures::update()
 	{
-        for (std::unordered_map<int, Future>::iterator it = m_futures.begin(); it != m_futures.end(); )
+        Future::Clock::time_point now = Future::Clock::now();
+
+        m_updating = true;
+
+        while (!m_deadlines.empty() && m_deadlines.top().m_when <= now)
         {
-            if (it->second.update(dt))
+            Deadline deadline = m_deadlines.top();
+            m_deadlines.pop();
+
+            std::unordered_map<int, Future>::iterator it = m_futures.find(deadline.m_id);
+
+            if (it == m_futures.end())
+                continue;
+
+            if (it->second.m_repeat == 0)
+            {
+                Future::Callback callback = std::move(it->second.m_callback);
+                m_futures.erase(it);
+                callback();
+                continue;
+            }
+
+            if (it->second.m_repeat > 0)
             {
-                it = m_futures.erase(it);
+                it->second.m_repeat--;
             }
-            else
+
+            Future::Clock::duration period = it->second.m_period;
+            Future::Clock::time_point next = deadline.m_when + period;
+
+            // after a long stall, skip the missed ticks instead of firing them all at once
+            if (next <= now && period.count() > 0)
             {
-                ++it;
+                next += period * ((now - next) / period + 1);
             }
+
+            m_scheduled.emplace_back(next, deadline.m_id);
+
+            // the callback may cancel its own future, so it's called on a copy
+            Future::Callback callback = it->second.m_callback;
+            callback();
+        }
+
+        m_updating = false;
+
+        for (const Deadline& deadline : m_scheduled)
+        {
+            m_deadlines.push(deadline);
         }
 
+        m_scheduled.clear();
+
+        // timers that keep being cancelled before they are due would pile up otherwise
+        m_deadlines.compact(m_futures.size(), [this](int id)
+        {
+            return m_futures.find(id) != m_futures.end();
+        });
+
 		if (!m_nextUpdate.empty())
 		{
-			for (Future::Callback callback : m_nextUpdate)
+            std::vector<Future::Callback> callbacks;
+            callbacks.swap(m_nextUpdate);
+
+			for (Future::Callback& callback : callbacks)
 			{
 				callback();
 			}
-
-			m_nextUpdate.clear();
 		}
 	}
 }
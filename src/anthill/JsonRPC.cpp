@@ -1,6 +1,6 @@
 
-#include "anthill/AnthillRuntime.h"
 #include "anthill/JsonRPC.h"
+#include "anthill/Tracing.h"
 
 #include "json/reader.h"
 #include "json/writer.h"
@@ -8,6 +8,9 @@
 namespace online
 {
     JsonRPC::JsonRPC() :
+        m_batching(false),
+        m_batch(Json::arrayValue),
+        m_replies(nullptr),
         m_nextId(1)
 	{
 
@@ -44,8 +47,7 @@ namespace online
             toWrite["id"] = id;
         }
         
-        Json::FastWriter writer;
-        write(writer.write(toWrite));
+        reply(toWrite);
     }
     
     void JsonRPC::writeResponse(const Json::Value result, int id)
@@ -60,8 +62,57 @@ namespace online
             toWrite["id"] = id;
         }
         
+        reply(toWrite);
+    }
+    
+    void JsonRPC::send(const Json::Value& message)
+    {
+        if (m_batching)
+        {
+            m_batch.append(message);
+            return;
+        }
+        
+        Json::FastWriter writer;
+        write(writer.write(message));
+    }
+    
+    void JsonRPC::reply(const Json::Value& message)
+    {
+        if (m_replies)
+        {
+            m_replies->append(message);
+            return;
+        }
+        
         Json::FastWriter writer;
-        write(writer.write(toWrite));
+        write(writer.write(message));
+    }
+    
+    void JsonRPC::beginBatch()
+    {
+        m_batching = true;
+    }
+    
+    void JsonRPC::flush()
+    {
+        m_batching = false;
+        
+        if (m_batch.empty())
+            return;
+        
+        Json::FastWriter writer;
+        
+        if (m_batch.size() == 1)
+        {
+            write(writer.write(m_batch[0]));
+        }
+        else
+        {
+            write(writer.write(m_batch));
+        }
+        
+        m_batch = Json::Value(Json::arrayValue);
     }
     
     void JsonRPC::update()
@@ -71,6 +122,40 @@ namespace online
         {
             received(data);
         }
+        
+        flush();
+        checkTimeouts();
+    }
+    
+    void JsonRPC::checkTimeouts()
+    {
+        if (m_deadlines.empty())
+            return;
+        
+        Clock::time_point now = Clock::now();
+        
+        // only the expired deadlines are touched; the ones already answered are skipped
+        while (!m_deadlines.empty() && m_deadlines.top().m_when <= now)
+        {
+            int id = m_deadlines.top().m_id;
+            m_deadlines.pop();
+            
+            ResponseHandlers::iterator it = m_responseHandlers.find(id);
+            
+            if (it == m_responseHandlers.end())
+                continue;
+            
+            ResponseHandler handler = it->second;
+            m_responseHandlers.erase(it);
+            
+            handler.m_failture(599, "Request Timeout", std::to_string( handler.m_timeout ));
+        }
+        
+        // the deadlines of the answered requests would pile up under steady traffic otherwise
+        m_deadlines.compact(m_responseHandlers.size(), [this](int id)
+        {
+            return m_responseHandlers.find(id) != m_responseHandlers.end();
+        });
     }
     
     void JsonRPC::received(const std::string& message)
@@ -83,6 +168,44 @@ namespace online
             return;
         }
         
+        if (!msg.isArray())
+        {
+            process(msg);
+            return;
+        }
+        
+        if (msg.empty())
+        {
+            writeError(-32600, "Invalid Request", "Empty batch.");
+            return;
+        }
+        
+        Json::Value replies(Json::arrayValue);
+        m_replies = &replies;
+        
+        for (const Json::Value& entry : msg)
+        {
+            process(entry);
+        }
+        
+        m_replies = nullptr;
+        
+        // a batch of notifications and responses gets no reply at all
+        if (!replies.empty())
+        {
+            Json::FastWriter writer;
+            write(writer.write(replies));
+        }
+    }
+    
+    void JsonRPC::process(const Json::Value& msg)
+    {
+        if (!msg.isObject())
+        {
+            writeError(-32600, "Invalid Request", "Not an object.");
+            return;
+        }
+        
         if (!msg.isMember("jsonrpc"))
         {
             writeError(-32600, "Invalid Request", "No 'jsonrpc' field.");
@@ -116,6 +239,7 @@ namespace online
             if (it != m_handlers.end())
             {
                 RequestHandler handler = it->second;
+                Tracer::Span span("rpc.handle", method);
             
                 bool called = false;
                 
@@ -159,11 +283,6 @@ namespace online
                 ResponseHandler handler = it->second;
                 m_responseHandlers.erase(it);
                 
-                if (handler.m_future)
-                {
-                    AnthillRuntime::Instance().getFutures().cancel(handler.m_future);
-                }
-                
                 if (hasResult)
                 {
                     handler.m_success(result);
@@ -202,6 +321,7 @@ namespace online
             if (it != m_handlers.end())
             {
                 RequestHandler handler = it->second;
+                Tracer::Span span("rpc.handle", method);
                 
                 handler(params, [=](const Json::Value& response)
                 {
@@ -240,8 +360,44 @@ namespace online
         m_handlers[method] = handler;
     }
     
+    void JsonRPC::setIdempotent(const std::string& method)
+    {
+        m_idempotentMethods.insert(method);
+    }
+    
     void JsonRPC::request(const std::string& method, Success success, Failture failture, const Json::Value& params, float timeout)
     {
+        Tracer& tracer = Tracer::get();
+        
+        if (tracer.isEnabled())
+        {
+            // the span ends whichever way the call does: a response, an error, a timeout or a disconnect
+            Tracer::SpanId span = tracer.begin("rpc", method);
+            
+            Success success_ = success;
+            Failture failture_ = failture;
+            
+            success = [span, success_](const Json::Value& response)
+            {
+                Tracer::get().end(span);
+                Tracer::Scope scope(span);
+                
+                if (success_) success_(response);
+            };
+            
+            failture = [span, failture_](int code, const std::string& message, const std::string& data)
+            {
+                Json::Value args;
+                args["code"] = code;
+                args["message"] = message;
+                
+                Tracer::get().end(span, args);
+                Tracer::Scope scope(span);
+                
+                if (failture_) failture_(code, message, data);
+            };
+        }
+        
         Json::Value toWrite;
         
         toWrite["jsonrpc"] = "2.0";
@@ -252,31 +408,39 @@ namespace online
         toWrite["id"] = currentId;
         toWrite["params"] = params;
         
-        int future = 0;
+        bool replayable = m_idempotentMethods.find(method) != m_idempotentMethods.end();
+        
+        // it would be dropped, and nothing would ever answer it
+        if (!replayable && !isWritable())
+        {
+            if (failture)
+                failture(1006, "Disconnected", "Rejected, because websocket is not connected");
+            
+            return;
+        }
         
         if (timeout)
         {
-            future = AnthillRuntime::Instance().getFutures().add(timeout, [this, currentId, timeout]()
-            {
-                ResponseHandlers::iterator it = m_responseHandlers.find(currentId);
-                
-                if (it == m_responseHandlers.end())
-                    return;
-                
-                it->second.m_failture(599, "Request Timeout", std::to_string( timeout ));
-                m_responseHandlers.erase(it);
-            });
+            Clock::duration duration = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<float>(timeout));
+            
+            m_deadlines.emplace(Clock::now() + duration, currentId);
         }
         
-        m_responseHandlers.emplace(
+        ResponseHandlers::iterator it = m_responseHandlers.emplace(
             std::piecewise_construct,
             std::forward_as_tuple(currentId),
-            std::forward_as_tuple(success, failture, future));
+            std::forward_as_tuple(success, failture, timeout)).first;
     
         m_nextId++;
         
-        Json::FastWriter writer;
-        write(writer.write(toWrite));
+        if (replayable)
+        {
+            Json::FastWriter writer;
+            it->second.m_replay = writer.write(toWrite);
+        }
+        
+        send(toWrite);
     }
     
     void JsonRPC::rpc(const std::string& method, const Json::Value& params)
@@ -287,24 +451,57 @@ namespace online
         toWrite["method"] = method;
         toWrite["params"] = params;
         
-        Json::FastWriter writer;
-        write(writer.write(toWrite));
+        send(toWrite);
     }
     
     void JsonRPC::rejectAllResponseHandlers(int code, const std::string& message, const std::string& data)
     {
-        Futures& futures = AnthillRuntime::Instance().getFutures();
+        ResponseHandlers handlers;
+        handlers.swap(m_responseHandlers);
+        m_deadlines = Deadlines();
+        m_batch = Json::Value(Json::arrayValue);
         
-        for (ResponseHandlers::const_iterator it = m_responseHandlers.begin(); it != m_responseHandlers.end(); it++)
+        for (ResponseHandlers::const_iterator it = handlers.begin(); it != handlers.end(); it++)
         {
-            if (it->second.m_future)
+            it->second.m_failture(code, message, data);
+        }
+    }
+    
+    void JsonRPC::rejectNonReplayableResponseHandlers(int code, const std::string& message, const std::string& data)
+    {
+        std::vector<ResponseHandler> rejected;
+        
+        // whatever was still batched is either rejected here or replayed after a reconnect
+        m_batch = Json::Value(Json::arrayValue);
+        
+        for (ResponseHandlers::iterator it = m_responseHandlers.begin(); it != m_responseHandlers.end(); )
+        {
+            if (it->second.m_replay.empty())
+            {
+                rejected.push_back(it->second);
+                it = m_responseHandlers.erase(it);
+            }
+            else
             {
-                futures.cancel(it->second.m_future);
+                ++it;
             }
+        }
         
-            it->second.m_failture(code, message, data);
+        for (const ResponseHandler& handler : rejected)
+        {
+            handler.m_failture(code, message, data);
         }
+    }
     
-        m_responseHandlers.clear();
+    void JsonRPC::replayResponseHandlers()
+    {
+        // the ids stay the same, so the responses are routed to the original handlers
+        for (ResponseHandlers::const_iterator it = m_responseHandlers.begin(); it != m_responseHandlers.end(); it++)
+        {
+            if (!it->second.m_replay.empty())
+            {
+                write(it->second.m_replay);
+            }
+        }
     }
 }
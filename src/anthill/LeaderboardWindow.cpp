@@ -0,0 +1,365 @@
+#include "anthill/LeaderboardWindow.h"
+#include "anthill/Log.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace online
+{
+	const size_t LeaderboardWindow::NO_END = std::numeric_limits<size_t>::max();
+
+	LeaderboardWindowPtr LeaderboardWindow::Create(const LeaderboardServicePtr& service, const std::string& name,
+		const std::string& order, const std::string& accessToken, int pageSize)
+	{
+		LeaderboardWindowPtr _object(new LeaderboardWindow(service, name, order, accessToken, pageSize));
+		if (!_object->init())
+			return LeaderboardWindowPtr(nullptr);
+
+		return _object;
+	}
+
+	LeaderboardWindow::LeaderboardWindow(const LeaderboardServicePtr& service, const std::string& name,
+		const std::string& order, const std::string& accessToken, int pageSize) :
+		m_service(service),
+		m_name(name),
+		m_order(order),
+		m_accessToken(accessToken),
+		m_pageSize(pageSize),
+		m_end(NO_END),
+		m_generation(0)
+	{
+		//
+	}
+
+	bool LeaderboardWindow::init()
+	{
+		return !m_service.expired() && m_pageSize > 0;
+	}
+
+	LeaderboardWindow::StringId LeaderboardWindow::intern(const std::string& value)
+	{
+		std::unordered_map<std::string, StringId>::iterator it = m_stringIds.find(value);
+
+		if (it != m_stringIds.end())
+			return it->second;
+
+		StringId id = (StringId)m_strings.size();
+
+		m_strings.push_back(value);
+		m_stringIds.emplace(value, id);
+
+		return id;
+	}
+
+	bool LeaderboardWindow::before(float a, float b) const
+	{
+		return m_order == "asc" ? a < b : a > b;
+	}
+
+	const Json::Value* LeaderboardWindow::getProfile(size_t position) const
+	{
+		std::unordered_map<size_t, Json::Value>::const_iterator it = m_profiles.find(position);
+		return it != m_profiles.end() ? &it->second : nullptr;
+	}
+
+	int LeaderboardWindow::findAccount(const std::string& account) const
+	{
+		std::unordered_map<std::string, StringId>::const_iterator id = m_stringIds.find(account);
+
+		if (id == m_stringIds.end())
+			return -1;
+
+		std::unordered_map<StringId, size_t>::const_iterator it = m_positions.find(id->second);
+		return it != m_positions.end() ? (int)it->second : -1;
+	}
+
+	void LeaderboardWindow::ensure(size_t offset, size_t count, Callback callback)
+	{
+		std::vector<size_t> pages;
+
+		size_t end = std::min(offset + count, m_end);
+
+		for (size_t page = offset - offset % m_pageSize; page < end; page += m_pageSize)
+		{
+			size_t last = std::min(page + m_pageSize, m_end);
+
+			for (size_t position = page; position < last; position++)
+			{
+				if (!isLoaded(position))
+				{
+					pages.push_back(page);
+					break;
+				}
+			}
+		}
+
+		if (pages.empty())
+		{
+			callback(*this, Request::SUCCESS);
+			return;
+		}
+
+		// the first failure is reported, once all of the pages are done
+		std::shared_ptr<size_t> left = std::make_shared<size_t>(pages.size());
+		std::shared_ptr<Request::Result> outcome = std::make_shared<Request::Result>(Request::SUCCESS);
+		std::weak_ptr<LeaderboardWindow> weak = shared_from_this();
+
+		for (size_t page: pages)
+		{
+			fetch(page, [weak, left, outcome, callback](Request::Result result)
+			{
+				if (!Request::isSuccessful(result) && Request::isSuccessful(*outcome))
+				{
+					*outcome = result;
+				}
+
+				LeaderboardWindowPtr self = weak.lock();
+
+				if (--*left == 0 && self)
+				{
+					callback(*self, *outcome);
+				}
+			});
+		}
+	}
+
+	void LeaderboardWindow::fetch(size_t page, PageCallback callback)
+	{
+		std::unordered_map<size_t, PageCallbacks>::iterator it = m_fetching.find(page);
+
+		// the page is on its way already
+		if (it != m_fetching.end())
+		{
+			it->second->push_back(callback);
+			return;
+		}
+
+		LeaderboardServicePtr service = m_service.lock();
+
+		if (!service)
+		{
+			callback(Request::CLIENT_ERROR);
+			return;
+		}
+
+		PageCallbacks callbacks = std::make_shared< std::vector<PageCallback> >();
+		callbacks->push_back(callback);
+		m_fetching[page] = callbacks;
+
+		std::weak_ptr<LeaderboardWindow> weak = shared_from_this();
+		uint32_t generation = m_generation;
+
+		service->getLeaderboardPage(m_name, m_order, (int)page, m_pageSize, false, m_accessToken,
+			[weak, page, callbacks, generation](const LeaderboardService& service, Request::Result result,
+				const Request& request, const Json::Value& data)
+		{
+			LeaderboardWindowPtr self = weak.lock();
+
+			if (!self)
+				return;
+
+			// cleared since
+			if (generation != self->m_generation)
+			{
+				result = Request::CLIENT_ERROR;
+			}
+			else
+			{
+				if (request.isSuccessful())
+				{
+					self->merge(page, data);
+
+					if (data.size() < (Json::ArrayIndex)self->m_pageSize)
+					{
+						self->m_end = page + data.size();
+					}
+				}
+
+				self->m_fetching.erase(page);
+			}
+
+			for (const PageCallback& callback: *callbacks)
+			{
+				callback(result);
+			}
+		});
+	}
+
+	void LeaderboardWindow::loadAroundMe(int count, Callback callback)
+	{
+		LeaderboardServicePtr service = m_service.lock();
+
+		if (!service)
+		{
+			callback(*this, Request::CLIENT_ERROR);
+			return;
+		}
+
+		std::weak_ptr<LeaderboardWindow> weak = shared_from_this();
+		uint32_t generation = m_generation;
+
+		service->getLeaderboardPage(m_name, m_order, 0, count, true, m_accessToken,
+			[weak, callback, generation](const LeaderboardService& service, Request::Result result, const Request& request, const Json::Value& data)
+		{
+			LeaderboardWindowPtr self = weak.lock();
+
+			if (!self)
+				return;
+
+			if (generation != self->m_generation)
+			{
+				callback(*self, Request::CLIENT_ERROR);
+				return;
+			}
+
+			if (request.isSuccessful() && data.size() > 0)
+			{
+				int rank = data[0]["rank"].asInt();
+
+				if (rank > 0)
+				{
+					self->merge((size_t)(rank - 1), data);
+				}
+			}
+
+			callback(*self, result);
+		});
+	}
+
+	void LeaderboardWindow::merge(size_t first, const Json::Value& data)
+	{
+		if (first + data.size() > m_rows.size())
+		{
+			m_rows.resize(first + data.size());
+		}
+
+		size_t position = first;
+
+		for (Json::ValueConstIterator it = data.begin(); it != data.end(); it++, position++)
+		{
+			const Json::Value& entry = *it;
+			Row& row = m_rows[position];
+
+			// whoever has been there before has moved since
+			if (row.loaded)
+			{
+				std::unordered_map<StringId, size_t>::iterator previous = m_positions.find(row.account);
+
+				if (previous != m_positions.end() && previous->second == position)
+				{
+					m_positions.erase(previous);
+				}
+			}
+
+			row.rank = entry["rank"].asInt();
+			row.score = entry["score"].asFloat();
+			row.displayName = intern(entry["display_name"].asString());
+			row.account = intern(entry["account"].asString());
+			row.loaded = true;
+
+			// an entry seen at another position before is not there anymore
+			std::unordered_map<StringId, size_t>::iterator moved = m_positions.find(row.account);
+
+			if (moved != m_positions.end() && moved->second != position)
+			{
+				m_rows[moved->second].loaded = false;
+				m_profiles.erase(moved->second);
+			}
+
+			m_positions[row.account] = position;
+
+			const Json::Value& profile = entry["profile"];
+
+			if (profile.isNull())
+			{
+				m_profiles.erase(position);
+			}
+			else
+			{
+				m_profiles[position] = profile;
+			}
+		}
+	}
+
+	void LeaderboardWindow::move(size_t from, size_t to)
+	{
+		// swaps the neighbours one by one, keeping the ranks by position
+		int step = to > from ? 1 : -1;
+
+		for (size_t position = from; position != to; position += step)
+		{
+			size_t next = position + step;
+
+			std::swap(m_rows[position], m_rows[next]);
+			std::swap(m_rows[position].rank, m_rows[next].rank);
+
+			m_positions[m_rows[position].account] = position;
+			m_positions[m_rows[next].account] = next;
+
+			Json::Value a, b;
+
+			std::unordered_map<size_t, Json::Value>::iterator first = m_profiles.find(position);
+			std::unordered_map<size_t, Json::Value>::iterator second = m_profiles.find(next);
+
+			bool hasFirst = first != m_profiles.end(), hasSecond = second != m_profiles.end();
+
+			if (hasFirst) a.swap(first->second);
+			if (hasSecond) b.swap(second->second);
+
+			m_profiles.erase(position);
+			m_profiles.erase(next);
+
+			if (hasFirst) m_profiles[next].swap(a);
+			if (hasSecond) m_profiles[position].swap(b);
+		}
+	}
+
+	void LeaderboardWindow::updateScore(const std::string& account, float score)
+	{
+		int found = findAccount(account);
+
+		if (found < 0)
+			return;
+
+		size_t position = (size_t)found;
+		m_rows[position].score = score;
+
+		// up, then down, only among the loaded neighbours
+		size_t target = position;
+
+		while (target > 0 && isLoaded(target - 1) && before(score, m_rows[target - 1].score))
+		{
+			target--;
+		}
+
+		if (target == position)
+		{
+			while (isLoaded(target + 1) && before(m_rows[target + 1].score, score))
+			{
+				target++;
+			}
+		}
+
+		if (target != position)
+		{
+			move(position, target);
+		}
+	}
+
+	void LeaderboardWindow::clear()
+	{
+		m_rows.clear();
+		m_profiles.clear();
+		m_positions.clear();
+		m_strings.clear();
+		m_stringIds.clear();
+		m_fetching.clear();
+		m_end = NO_END;
+		m_generation++;
+	}
+
+	LeaderboardWindow::~LeaderboardWindow()
+	{
+		//
+	}
+}
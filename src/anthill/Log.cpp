@@ -0,0 +1,392 @@
+#include "anthill/Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace online
+{
+	// a single producer (the owning thread), single consumer (the sink) queue
+	class LogRing
+	{
+	public:
+		static const size_t Capacity = 1024;
+
+		struct Entry
+		{
+			std::time_t m_time;
+			Log::Level m_level;
+			std::string m_message;
+		};
+
+	public:
+		LogRing() :
+			m_head(0),
+			m_tail(0),
+			m_dropped(0)
+		{}
+
+		// false if the ring is full, 'wake' tells if the sink should be woken up:
+		// on the first line since it has drained the ring, and once the ring is half full
+		bool push(std::time_t time, Log::Level level, std::string&& message, bool& wake)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			size_t tail = m_tail.load(std::memory_order_acquire);
+
+			if (head - tail >= Capacity)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			Entry& entry = m_entries[head % Capacity];
+			entry.m_time = time;
+			entry.m_level = level;
+			entry.m_message = std::move(message);
+
+			wake = head == tail || head - tail == Capacity / 2;
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(Entry& entry)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			size_t head = m_head.load(std::memory_order_acquire);
+
+			if (tail == head)
+				return false;
+
+			entry = std::move(m_entries[tail % Capacity]);
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool empty() const
+		{
+			return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+		}
+
+		unsigned int takeDropped()
+		{
+			return m_dropped.exchange(0, std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<size_t> m_head;
+		std::atomic<size_t> m_tail;
+		std::atomic<unsigned int> m_dropped;
+		Entry m_entries[Capacity];
+	};
+
+	class LogSink
+	{
+	public:
+		static LogSink& get()
+		{
+			static LogSink instance;
+			return instance;
+		}
+
+		static bool isAlive()
+		{
+			return s_alive.load();
+		}
+
+		// gone for good, get() would construct it again over the destroyed one
+		static bool isDestroyed()
+		{
+			return s_destroyed.load();
+		}
+
+		LogSink() :
+			m_signalled(false),
+			m_stopping(false),
+			m_flushRequests(0),
+			m_flushes(0),
+			m_level(Log::LEVEL_DEBUG)
+		{
+			s_alive = true;
+			m_thread = std::thread(&LogSink::run, this);
+		}
+
+		~LogSink()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stopping = true;
+			}
+
+			m_wakeUp.notify_one();
+			m_thread.join();
+
+			s_alive = false;
+			s_destroyed = true;
+		}
+
+		void add(const std::shared_ptr<LogRing>& ring)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_rings.push_back(ring);
+		}
+
+		void wakeUp()
+		{
+			m_signalled = true;
+			m_wakeUp.notify_one();
+		}
+
+		void setCallback(Log::Callback callback, bool onSinkThread)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_callback = onSinkThread ? callback : nullptr;
+			}
+
+			std::shared_ptr<const Log::Callback> direct;
+
+			if (callback && !onSinkThread)
+			{
+				direct = std::make_shared<const Log::Callback>(callback);
+			}
+
+			std::atomic_store(&m_direct, direct);
+		}
+
+		// the callback to call on the logging thread itself, if any
+		std::shared_ptr<const Log::Callback> getDirect() const
+		{
+			return std::atomic_load(&m_direct);
+		}
+
+		void setLevel(Log::Level level)
+		{
+			m_level = level;
+		}
+
+		Log::Level getLevel() const
+		{
+			return m_level.load(std::memory_order_relaxed);
+		}
+
+		void flush()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			unsigned int request = ++m_flushRequests;
+
+			m_wakeUp.notify_one();
+			m_flushed.wait(lock, [this, request]() { return m_flushes >= request || m_stopping; });
+		}
+
+		static void write(const Log::Callback& callback, std::time_t time, Log::Level level, const std::string& message)
+		{
+			static const char* const prefixes[] = { "debug: ", "", "warning: ", "error: " };
+
+			if (callback)
+			{
+				callback(message);
+				return;
+			}
+
+			char foo[32];
+
+			if (0 < strftime(foo, sizeof(foo), "[%T%z %F] ", std::localtime(&time)))
+			{
+				std::cout << "[ *********** ONLINE *********** ] " << foo << " " << prefixes[level] << message << "\n";
+			}
+		}
+
+	private:
+		void run()
+		{
+			std::vector< std::shared_ptr<LogRing> > rings;
+			Log::Callback callback;
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			while (true)
+			{
+				// the producers only wake the sink up now and then, and a wake up
+				// might come in between the passes, so it looks around now and then too
+				m_wakeUp.wait_for(lock, std::chrono::milliseconds(250), [this]()
+				{
+					return m_signalled.load() || m_stopping || m_flushRequests != m_flushes;
+				});
+
+				m_signalled = false;
+
+				bool stopping = m_stopping;
+				unsigned int flushRequests = m_flushRequests;
+
+				rings = m_rings;
+				callback = m_callback;
+
+				lock.unlock();
+
+				bool written = false;
+
+				for (const std::shared_ptr<LogRing>& ring : rings)
+				{
+					LogRing::Entry entry;
+
+					while (ring->pop(entry))
+					{
+						write(callback, entry.m_time, entry.m_level, entry.m_message);
+						written = true;
+					}
+
+					unsigned int dropped = ring->takeDropped();
+
+					if (dropped)
+					{
+						write(callback, std::time(nullptr), Log::LEVEL_WARNING, std::to_string(dropped) + " log lines dropped");
+						written = true;
+					}
+				}
+
+				if (written && !callback)
+				{
+					std::cout.flush();
+				}
+
+				rings.clear();
+
+				lock.lock();
+
+				// the rings of the threads that are gone, once drained
+				for (std::vector< std::shared_ptr<LogRing> >::iterator it = m_rings.begin(); it != m_rings.end(); )
+				{
+					if (it->use_count() == 1 && (*it)->empty())
+					{
+						it = m_rings.erase(it);
+						continue;
+					}
+
+					it++;
+				}
+
+				m_flushes = flushRequests;
+				m_flushed.notify_all();
+
+				if (stopping)
+					break;
+			}
+		}
+
+	private:
+		static std::atomic<bool> s_alive;
+		static std::atomic<bool> s_destroyed;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wakeUp;
+		std::condition_variable m_flushed;
+		std::vector< std::shared_ptr<LogRing> > m_rings;
+		Log::Callback m_callback;
+		std::shared_ptr<const Log::Callback> m_direct;
+		std::atomic<bool> m_signalled;
+		bool m_stopping;
+		unsigned int m_flushRequests;
+		unsigned int m_flushes;
+		std::atomic<Log::Level> m_level;
+		std::thread m_thread;
+	};
+
+	std::atomic<bool> LogSink::s_alive(false);
+	std::atomic<bool> LogSink::s_destroyed(false);
+
+	// one ring per thread, shared by Log::get() and the temporary Log() objects
+	static std::shared_ptr<LogRing> threadRing()
+	{
+		static thread_local std::shared_ptr<LogRing> ring;
+
+		if (!ring && !LogSink::isDestroyed())
+		{
+			ring = std::make_shared<LogRing>();
+			LogSink::get().add(ring);
+		}
+
+		return ring;
+	}
+
+	Log& Log::get(Level level)
+	{
+		static thread_local Log instance;
+
+		instance.m_level = level;
+		instance.m_enabled = !LogSink::isAlive() || level >= LogSink::get().getLevel();
+
+		return instance;
+	}
+
+	Log::Log() :
+		m_level(LEVEL_INFO),
+		m_enabled(true),
+		m_ring(threadRing())
+	{
+		//
+	}
+
+	Log::~Log()
+	{
+		//
+	}
+
+	void Log::setLevel(Level level)
+	{
+		LogSink::get().setLevel(level);
+	}
+
+	void Log::flush()
+	{
+		LogSink::get().flush();
+	}
+
+	void Log::overrideLog(Callback callback, bool onSinkThread)
+	{
+		LogSink::get().setCallback(callback, onSinkThread);
+	}
+
+	Log& Log::operator<<(std::ostream&(*f)(std::ostream&))
+	{
+		std::ostream& (*pEndl)(std::ostream &) = &(std::endl);
+
+		if (f != pEndl)
+		{
+			m_oss << f;
+			return *this;
+		}
+
+		if (m_enabled)
+		{
+			std::string message = m_oss.str();
+
+			std::shared_ptr<const Callback> direct;
+
+			if (!LogSink::isAlive() || !m_ring)
+			{
+				// the process is shutting down
+				LogSink::write(nullptr, std::time(nullptr), m_level, message);
+			}
+			else if ((direct = LogSink::get().getDirect()))
+			{
+				(*direct)(message);
+			}
+			else
+			{
+				bool wake = false;
+
+				if (m_ring->push(std::time(nullptr), m_level, std::move(message), wake) && wake)
+				{
+					LogSink::get().wakeUp();
+				}
+			}
+		}
+
+		m_oss.str("");
+		return *this;
+	}
+}
@@ -0,0 +1,225 @@
+
+#include "anthill/Pipeline.h"
+#include "anthill/Log.h"
+#include "anthill/Utils.h"
+
+namespace online
+{
+	PipelinePtr Pipeline::Create(const std::string& name)
+	{
+		return PipelinePtr(new Pipeline(name));
+	}
+
+	Pipeline::Pipeline(const std::string& name) :
+		m_name(name),
+		m_running(false),
+		m_failed(false),
+		m_scheduling(false),
+		m_rescheduled(false)
+	{
+		//
+	}
+
+	Pipeline::~Pipeline()
+	{
+		//
+	}
+
+	void Pipeline::addStage(const std::string& name, const std::set<std::string>& dependencies, StageFunction function)
+	{
+		OnlineAssert(!m_running, "Cannot add a stage to a running pipeline.");
+		OnlineAssert(!hasStage(name), "Stage " + name + " already exists.");
+
+		Stage stage;
+
+		stage.name = name;
+		stage.dependencies = dependencies;
+		stage.function = function;
+		stage.status = STAGE_PENDING;
+		stage.span = 0;
+
+		m_stages.push_back(stage);
+	}
+
+	bool Pipeline::hasStage(const std::string& name) const
+	{
+		for (const Stage& stage : m_stages)
+		{
+			if (stage.name == name)
+				return true;
+		}
+
+		return false;
+	}
+
+	void Pipeline::start(CompleteCallback callback)
+	{
+		OnlineAssert(!m_running, "Pipeline is already running.");
+
+		for (const Stage& stage : m_stages)
+		{
+			for (const std::string& dependency : stage.dependencies)
+			{
+				OnlineAssert(hasStage(dependency), "Stage " + stage.name + " depends on unknown stage " + dependency);
+			}
+		}
+
+		m_callback = callback;
+		m_timings.clear();
+		m_started = Clock::now();
+		m_running = true;
+		m_failed = false;
+
+		for (Stage& stage : m_stages)
+		{
+			stage.status = STAGE_PENDING;
+		}
+
+		schedule();
+	}
+
+	float Pipeline::since(Clock::time_point time) const
+	{
+		return std::chrono::duration<float>(Clock::now() - time).count();
+	}
+
+	void Pipeline::schedule()
+	{
+		// a stage may finish right inside its function, which schedules again
+		if (m_scheduling)
+		{
+			m_rescheduled = true;
+			return;
+		}
+
+		PipelinePtr self = shared_from_this();
+		m_scheduling = true;
+
+		do
+		{
+			m_rescheduled = false;
+
+			for (size_t i = 0; i < m_stages.size() && !m_failed; i++)
+			{
+				if (m_stages[i].status != STAGE_PENDING)
+					continue;
+
+				bool ready = true;
+
+				for (const std::string& dependency : m_stages[i].dependencies)
+				{
+					for (const Stage& other : m_stages)
+					{
+						if (other.name == dependency && other.status != STAGE_SUCCEEDED)
+						{
+							ready = false;
+							break;
+						}
+					}
+
+					if (!ready)
+						break;
+				}
+
+				if (!ready)
+					continue;
+
+				m_stages[i].status = STAGE_RUNNING;
+				m_stages[i].started = Clock::now();
+
+				Log::get() << m_name << ": Stage '" << m_stages[i].name << "' started." << std::endl;
+
+				Tracer& tracer = Tracer::get();
+
+				if (tracer.isEnabled())
+				{
+					m_stages[i].span = tracer.begin("stage", m_name + ": " + m_stages[i].name);
+				}
+
+				Tracer::Scope scope(m_stages[i].span);
+				std::weak_ptr<Pipeline> weak = self;
+
+				StageFunction function = m_stages[i].function;
+				function([weak, i](bool success)
+				{
+					if (PipelinePtr pipeline = weak.lock())
+					{
+						pipeline->finished(i, success);
+					}
+				});
+			}
+		}
+		while (m_rescheduled);
+
+		m_scheduling = false;
+
+		if (!m_running)
+			return;
+
+		size_t running = 0;
+		size_t succeeded = 0;
+
+		for (const Stage& stage : m_stages)
+		{
+			if (stage.status == STAGE_RUNNING)
+				running++;
+			else if (stage.status == STAGE_SUCCEEDED)
+				succeeded++;
+		}
+
+		if (running)
+			return;
+
+		m_running = false;
+
+		// either everything succeeded, or something failed and no stage is left to wait for
+		bool success = !m_failed && succeeded == m_stages.size();
+
+		Log::get() << m_name << ": " << (success ? "Ready" : "Failed") << " in " << since(m_started) << "s." << std::endl;
+
+		if (m_callback)
+		{
+			CompleteCallback callback = m_callback;
+			m_callback = nullptr;
+			callback(success, m_timings);
+		}
+	}
+
+	void Pipeline::finished(size_t index, bool success)
+	{
+		Stage& stage = m_stages[index];
+
+		if (stage.status != STAGE_RUNNING)
+			return;
+
+		stage.status = success ? STAGE_SUCCEEDED : STAGE_FAILED;
+
+		if (stage.span)
+		{
+			Json::Value args;
+			args["success"] = success;
+
+			Tracer::get().end(stage.span, args);
+			stage.span = 0;
+		}
+
+		StageTiming timing;
+
+		timing.name = stage.name;
+		timing.started = std::chrono::duration<float>(stage.started - m_started).count();
+		timing.duration = since(stage.started);
+		timing.success = success;
+
+		m_timings.push_back(timing);
+
+		Log::get() << m_name << ": Stage '" << stage.name << "' " << (success ? "succeeded" : "failed") <<
+			" in " << timing.duration << "s." << std::endl;
+
+		if (!success)
+		{
+			m_failed = true;
+		}
+
+		schedule();
+	}
+}
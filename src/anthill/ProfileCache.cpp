@@ -0,0 +1,171 @@
+#include "anthill/ProfileCache.h"
+
+namespace online
+{
+	ProfileCache::ProfileCache()
+	{
+		//
+	}
+
+	void ProfileCache::setPolicy(const Policy& policy)
+	{
+		m_policy = policy;
+
+		if (!m_policy.enabled)
+		{
+			clear();
+			return;
+		}
+
+		trim();
+	}
+
+	std::string ProfileCache::key(const std::string& account, const std::string& path)
+	{
+		std::string result;
+		result.reserve(account.size() + path.size() + 1);
+		result.append(account).append(1, '\n').append(path);
+		return result;
+	}
+
+	bool ProfileCache::overlaps(const std::string& a, const std::string& b)
+	{
+		if (a.empty() || b.empty())
+			return true;
+
+		const std::string& shorter = a.size() < b.size() ? a : b;
+		const std::string& longer = a.size() < b.size() ? b : a;
+
+		if (longer.compare(0, shorter.size(), shorter) != 0)
+			return false;
+
+		return longer.size() == shorter.size() || longer[shorter.size()] == '/';
+	}
+
+	bool ProfileCache::get(const std::string& account, const std::string& path, Json::Value& profile)
+	{
+		if (!m_policy.enabled)
+			return false;
+
+		Clock::time_point now = Clock::now();
+
+		// the path itself first, and then its parents up to the whole profile
+		std::string parent = path;
+
+		while (true)
+		{
+			std::unordered_map<std::string, Entries::iterator>::iterator found = m_index.find(key(account, parent));
+
+			if (found != m_index.end())
+			{
+				Entries::iterator it = found->second;
+
+				if (it->expires <= now)
+				{
+					remove(it);
+				}
+				else
+				{
+					m_entries.splice(m_entries.begin(), m_entries, it);
+
+					const Json::Value* value = &it->profile;
+
+					// walk down from the parent to the path
+					size_t start = parent.empty() ? 0 : parent.size() + 1;
+
+					while (value && start < path.size())
+					{
+						size_t end = path.find('/', start);
+						if (end == std::string::npos)
+							end = path.size();
+
+						value = value->isObject() ? &(*value)[path.substr(start, end - start)] : nullptr;
+						start = end + 1;
+					}
+
+					profile = value ? *value : Json::Value();
+					return true;
+				}
+			}
+
+			if (parent.empty())
+				return false;
+
+			size_t slash = parent.rfind('/');
+			parent = slash == std::string::npos ? "" : parent.substr(0, slash);
+		}
+	}
+
+	void ProfileCache::put(const std::string& account, const std::string& path, const Json::Value& profile)
+	{
+		if (!m_policy.enabled)
+			return;
+
+		// whatever has been cached under it is outdated now
+		for (Entries::iterator it = m_entries.begin(); it != m_entries.end();)
+		{
+			Entries::iterator next = std::next(it);
+
+			if (it->account == account && it->path.size() > path.size() && overlaps(it->path, path))
+			{
+				remove(it);
+			}
+
+			it = next;
+		}
+
+		std::string k = key(account, path);
+		std::unordered_map<std::string, Entries::iterator>::iterator found = m_index.find(k);
+
+		if (found != m_index.end())
+		{
+			remove(found->second);
+		}
+
+		Entry entry;
+		entry.account = account;
+		entry.path = path;
+		entry.profile = profile;
+		entry.expires = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(m_policy.ttl));
+
+		m_entries.push_front(std::move(entry));
+		m_index[k] = m_entries.begin();
+
+		trim();
+	}
+
+	void ProfileCache::invalidate(const std::string& account, const std::string& path)
+	{
+		for (Entries::iterator it = m_entries.begin(); it != m_entries.end();)
+		{
+			Entries::iterator next = std::next(it);
+
+			if (it->account == account && overlaps(it->path, path))
+			{
+				remove(it);
+			}
+
+			it = next;
+		}
+	}
+
+	void ProfileCache::clear()
+	{
+		m_entries.clear();
+		m_index.clear();
+	}
+
+	void ProfileCache::remove(Entries::iterator it)
+	{
+		m_index.erase(key(it->account, it->path));
+		m_entries.erase(it);
+	}
+
+	void ProfileCache::trim()
+	{
+		while (m_entries.size() > m_policy.maxEntries)
+		{
+			remove(std::prev(m_entries.end()));
+		}
+	}
+}
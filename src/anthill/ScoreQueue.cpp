@@ -0,0 +1,408 @@
+#include "anthill/ScoreQueue.h"
+#include "anthill/AnthillRuntime.h"
+#include "anthill/Log.h"
+
+#include "anthill/services/EventService.h"
+#include "anthill/services/LeaderboardService.h"
+#include "anthill/services/LoginService.h"
+
+#include <json/reader.h>
+#include <json/writer.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace online
+{
+	ScoreQueuePtr ScoreQueue::Create()
+	{
+		ScoreQueuePtr _object(new ScoreQueue());
+		if (!_object->init())
+			return ScoreQueuePtr(nullptr);
+
+		return _object;
+	}
+
+	ScoreQueue::ScoreQueue() :
+		m_loaded(false),
+		m_nextFlush(Clock::now()),
+		m_backoff(0)
+	{
+		//
+	}
+
+	bool ScoreQueue::init()
+	{
+		return true;
+	}
+
+	std::string ScoreQueue::key(const std::string& account, Kind kind, const std::string& id, const std::string& order)
+	{
+		return account + "/" + (kind == LEADERBOARD ? "leaderboard/" + order + "/" : "event/") + id;
+	}
+
+	std::string ScoreQueue::getCurrentAccount() const
+	{
+		LoginServicePtr login = AnthillRuntime::Instance().get<LoginService>();
+		return login ? login->getCurrentAccount() : std::string();
+	}
+
+	void ScoreQueue::add(const std::string& account, Kind kind, const std::string& id, const std::string& order,
+		double score, const Json::Value& options)
+	{
+		if (m_pending.empty() && m_backoff == 0)
+		{
+			m_nextFlush = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+				std::chrono::duration<float>(m_policy.flushInterval));
+		}
+
+		std::string k = key(account, kind, id, order);
+		std::map<std::string, Pending>::iterator it = m_pending.find(k);
+
+		if (it == m_pending.end())
+		{
+			Pending& pending = m_pending[k];
+
+			pending.kind = kind;
+			pending.account = account;
+			pending.id = id;
+			pending.order = order;
+			pending.score = score;
+			pending.options = options;
+		}
+		else
+		{
+			Pending& pending = it->second;
+
+			if (kind == EVENT)
+			{
+				pending.score += score;
+			}
+			else if (order == "asc" ? score < pending.score : score > pending.score)
+			{
+				pending.score = score;
+				pending.options = options;
+			}
+		}
+	}
+
+	void ScoreQueue::postLeaderboardScore(const std::string& name, const std::string& order, float score,
+		const std::string& displayName, int expireIn, const Json::Value& profile)
+	{
+		Json::Value options(Json::objectValue);
+
+		options["display_name"] = displayName;
+		options["expire_in"] = expireIn;
+
+		if (!profile.isNull())
+		{
+			options["profile"] = profile;
+		}
+
+		add(getCurrentAccount(), LEADERBOARD, name, order, score, options);
+		save();
+	}
+
+	void ScoreQueue::addEventScore(const std::string& eventId, uint64_t score, bool autoJoin,
+		const std::string& leaderboardDisplayName, uint64_t leaderboardExpireIn)
+	{
+		Json::Value options(Json::objectValue);
+
+		options["auto_join"] = autoJoin;
+
+		if (!leaderboardDisplayName.empty())
+		{
+			options["display_name"] = leaderboardDisplayName;
+			options["expire_in"] = (Json::UInt64)leaderboardExpireIn;
+		}
+
+		add(getCurrentAccount(), EVENT, eventId, "", (double)score, options);
+		save();
+	}
+
+	void ScoreQueue::flush()
+	{
+		// a server that has asked to slow down is not asked again before it's time
+		if (m_backoff > 0)
+			return;
+
+		m_nextFlush = Clock::now();
+	}
+
+	void ScoreQueue::update()
+	{
+		if (!m_loaded)
+		{
+			m_loaded = true;
+			load();
+
+			// along with what's been posted before
+			if (!m_pending.empty())
+			{
+				save();
+			}
+		}
+
+		if (m_pending.empty())
+			return;
+
+		Clock::time_point now = Clock::now();
+
+		if (now < m_nextFlush)
+			return;
+
+		m_nextFlush = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(m_policy.flushInterval));
+
+		std::string account = getCurrentAccount();
+
+		// not logged in yet, kept until then
+		if (account.empty())
+			return;
+
+		adopt(account);
+
+		std::vector<std::string> keys;
+
+		for (const std::map<std::string, Pending>::value_type& entry: m_pending)
+		{
+			// the ones of another account wait for it to log in again
+			if (entry.second.sending || entry.second.account != account)
+				continue;
+
+			keys.push_back(entry.first);
+
+			if (keys.size() >= m_policy.maxPerFlush)
+				break;
+		}
+
+		for (const std::string& k: keys)
+		{
+			send(k);
+		}
+	}
+
+	void ScoreQueue::adopt(const std::string& account)
+	{
+		std::vector<Pending> orphans;
+
+		for (std::map<std::string, Pending>::iterator it = m_pending.begin(); it != m_pending.end();)
+		{
+			if (it->second.account.empty())
+			{
+				orphans.push_back(it->second);
+				it = m_pending.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+
+		if (orphans.empty())
+			return;
+
+		for (const Pending& pending: orphans)
+		{
+			add(account, pending.kind, pending.id, pending.order, pending.score, pending.options);
+		}
+
+		save();
+	}
+
+	void ScoreQueue::send(const std::string& k)
+	{
+		AnthillRuntime& runtime = AnthillRuntime::Instance();
+		LoginServicePtr login = runtime.get<LoginService>();
+
+		// not authenticated yet, kept until then
+		if (!login || login->getCurrentAccessToken().empty())
+			return;
+
+		const std::string& accessToken = login->getCurrentAccessToken();
+
+		Pending& pending = m_pending[k];
+
+		// never with the token of someone else
+		if (pending.account != login->getCurrentAccount())
+			return;
+		const Json::Value& options = pending.options;
+
+		if (pending.kind == LEADERBOARD)
+		{
+			LeaderboardServicePtr leaderboard = runtime.get<LeaderboardService>();
+
+			if (!leaderboard)
+				return;
+
+			pending.sending = true;
+			pending.sent = pending.score;
+
+			leaderboard->addLeaderboardEntry(pending.id, pending.order, (float)pending.score,
+				options["display_name"].asString(), options["expire_in"].asInt(), options["profile"], accessToken,
+				[this, k](const LeaderboardService& service, Request::Result result, const Request& request)
+			{
+				sent(k, result, request);
+			});
+		}
+		else
+		{
+			EventServicePtr events = runtime.get<EventService>();
+
+			if (!events)
+				return;
+
+			pending.sending = true;
+			pending.sent = pending.score;
+
+			EventLeaderboardInfo info;
+
+			if (options.isMember("display_name"))
+			{
+				info = EventLeaderboardInfo(options["display_name"].asString(), options["expire_in"].asUInt64());
+			}
+
+			events->addScore(pending.id, (uint64_t)pending.score, accessToken,
+				[this, k](const EventService& service, Request::Result result, const Request& request, uint64_t updatedScore)
+			{
+				sent(k, result, request);
+			}, info, options["auto_join"].asBool());
+		}
+	}
+
+	void ScoreQueue::sent(const std::string& k, Request::Result result, const Request& request)
+	{
+		std::map<std::string, Pending>::iterator it = m_pending.find(k);
+
+		if (it == m_pending.end())
+			return;
+
+		Pending& pending = it->second;
+		pending.sending = false;
+
+		Kind kind = pending.kind;
+		std::string id = pending.id;
+
+		// FORBIDDEN is for good, the same token is not let in later either
+		bool retry = result == Request::TOO_MANY_REQUESTS || result == Request::CONNECTION_ERROR ||
+			result == Request::UNAUTHORIZED || result >= Request::INTERNAL_ERROR;
+
+		if (retry)
+		{
+			m_backoff = m_backoff > 0 ? std::min(m_backoff * 2, m_policy.maxRetryInterval) : m_policy.retryInterval;
+
+			std::string retryAfter = request.getResponseHeader("Retry-After");
+
+			if (!retryAfter.empty() && atoi(retryAfter.c_str()) > 0)
+			{
+				m_backoff = (float)atoi(retryAfter.c_str());
+			}
+
+			Log::get() << "Failed to post a score (" << result << "), trying again in " << m_backoff << "s" << std::endl;
+
+			m_nextFlush = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(m_backoff));
+			return;
+		}
+
+		m_backoff = 0;
+
+		if (Request::isSuccessful(result))
+		{
+			// the scores posted meanwhile are still to be sent
+			if (kind == EVENT)
+			{
+				pending.score -= pending.sent;
+			}
+
+			if (kind == LEADERBOARD ? pending.score == pending.sent : pending.score <= 0)
+			{
+				m_pending.erase(it);
+			}
+		}
+		else
+		{
+			Log::get() << "A score has been rejected: " << k << ": " << result << ": " << request.getResponseAsString() << std::endl;
+			m_pending.erase(it);
+		}
+
+		save();
+
+		if (m_onSubmitted)
+		{
+			m_onSubmitted(kind, id, result);
+		}
+	}
+
+	void ScoreQueue::load()
+	{
+		const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+
+		if (!storage || !storage->has(Storage::StoragePendingScoresField))
+			return;
+
+		Json::Value saved;
+
+		if (!Json::Reader().parse(storage->get(Storage::StoragePendingScoresField), saved) || !saved.isArray())
+			return;
+
+		for (Json::ValueConstIterator it = saved.begin(); it != saved.end(); it++)
+		{
+			const Json::Value& entry = *it;
+
+			// saved before the scores knew their account, whose they are is anyone's guess
+			if (!entry.isMember("account"))
+			{
+				Log::get() << "A pending score of an unknown account is dropped: " << entry["id"].asString() << std::endl;
+				continue;
+			}
+
+			add(entry["account"].asString(), entry["kind"].asInt() == EVENT ? EVENT : LEADERBOARD, entry["id"].asString(),
+				entry["order"].asString(), entry["score"].asDouble(), entry["options"]);
+		}
+
+		if (!m_pending.empty())
+		{
+			Log::get() << "Pending scores from the last time: " << m_pending.size() << std::endl;
+		}
+	}
+
+	void ScoreQueue::save()
+	{
+		// nothing is saved over what's been stored before it's loaded
+		if (!m_loaded || !AnthillRuntime::IsInstanceValid())
+			return;
+
+		const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+
+		if (!storage)
+			return;
+
+		if (m_pending.empty())
+		{
+			storage->remove(Storage::StoragePendingScoresField);
+			storage->save();
+			return;
+		}
+
+		Json::Value saved(Json::arrayValue);
+
+		for (const std::map<std::string, Pending>::value_type& entry: m_pending)
+		{
+			Json::Value& item = saved.append(Json::Value(Json::objectValue));
+
+			item["kind"] = (int)entry.second.kind;
+			item["account"] = entry.second.account;
+			item["id"] = entry.second.id;
+			item["order"] = entry.second.order;
+			item["score"] = entry.second.score;
+			item["options"] = entry.second.options;
+		}
+
+		storage->set(Storage::StoragePendingScoresField, Json::FastWriter().write(saved));
+		storage->save();
+	}
+
+	ScoreQueue::~ScoreQueue()
+	{
+		//
+	}
+}
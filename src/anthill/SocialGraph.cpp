@@ -0,0 +1,446 @@
+#include "anthill/SocialGraph.h"
+#include "anthill/AnthillRuntime.h"
+
+#include "anthill/services/ProfileService.h"
+
+namespace online
+{
+	SocialGraphPtr SocialGraph::Create(const SocialServicePtr& social, const std::string& accessToken,
+		const std::set<std::string>& profileFields)
+	{
+		SocialGraphPtr _object(new SocialGraph(social, accessToken, profileFields));
+		if (!_object->init())
+			return SocialGraphPtr(nullptr);
+
+		return _object;
+	}
+
+	SocialGraph::SocialGraph(const SocialServicePtr& social, const std::string& accessToken,
+		const std::set<std::string>& profileFields) :
+		m_social(social),
+		m_accessToken(accessToken),
+		m_profileFields(profileFields),
+		m_fetching(0),
+		m_fetchResult(Request::SUCCESS),
+		m_synced(false),
+		m_stale(false),
+		m_revision(0)
+	{
+		//
+	}
+
+	bool SocialGraph::init()
+	{
+		return !m_social.expired();
+	}
+
+	void SocialGraph::changed()
+	{
+		m_revision++;
+
+		if (m_onChanged)
+		{
+			m_onChanged(*this);
+		}
+	}
+
+	void SocialGraph::sync(Callback callback, bool force)
+	{
+		bool fresh = m_synced && !m_stale &&
+			std::chrono::duration<float>(Clock::now() - m_syncedAt).count() < m_policy.maxAge;
+
+		if (fresh && !force)
+		{
+			callback(*this, Request::SUCCESS);
+			return;
+		}
+
+		m_syncCallbacks.push_back(callback);
+
+		// joins the one in progress
+		if (m_fetching > 0)
+			return;
+
+		SocialServicePtr social = m_social.lock();
+
+		if (!social)
+		{
+			fetched(Request::CLIENT_ERROR);
+			return;
+		}
+
+		m_fetching = 2;
+		m_fetchResult = Request::SUCCESS;
+		m_fetchedConnections.clear();
+		m_fetchedRequests.clear();
+
+		std::weak_ptr<SocialGraph> weak = shared_from_this();
+
+		// the lists only, the profiles are looked up separately for the new accounts
+		social->getConnections(m_accessToken, std::set<std::string>(),
+			[weak](const SocialService& service, Request::Result result, const Request& request, const SocialConnections& connections)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (!self)
+				return;
+
+			self->m_fetchedConnections = connections;
+			self->fetched(result);
+		});
+
+		social->getRequests(m_accessToken, std::set<std::string>(),
+			[weak](const SocialService& service, Request::Result result, const Request& request, const SocialRequests& requests)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (!self)
+				return;
+
+			for (const SocialRequest& entry: requests)
+			{
+				self->m_fetchedRequests.emplace(entry.getKey(), entry);
+			}
+
+			self->fetched(result);
+		});
+	}
+
+	void SocialGraph::fetched(Request::Result result)
+	{
+		if (!Request::isSuccessful(result))
+		{
+			m_fetchResult = result;
+		}
+
+		if (m_fetching > 0 && --m_fetching > 0)
+			return;
+
+		if (Request::isSuccessful(m_fetchResult))
+		{
+			// the profiles shown so far are kept, only the accounts new to the lists are looked up
+			std::unordered_map<std::string, Json::Value> shown;
+
+			for (const SocialConnections::value_type& entry: m_connections)
+			{
+				if (!entry.second.m_profile.isNull())
+					shown[entry.first] = entry.second.m_profile;
+			}
+
+			for (const Requests::value_type& entry: m_requests)
+			{
+				if (!entry.second.m_profile.isNull())
+					shown[getAccount(entry.second)] = entry.second.m_profile;
+			}
+
+			m_connections.swap(m_fetchedConnections);
+			m_requests.swap(m_fetchedRequests);
+
+			m_synced = true;
+			m_stale = false;
+			m_syncedAt = Clock::now();
+
+			std::set<std::string> accounts;
+
+			for (SocialConnections::value_type& entry: m_connections)
+			{
+				std::unordered_map<std::string, Json::Value>::const_iterator it = shown.find(entry.first);
+
+				if (it != shown.end())
+					entry.second.m_profile = it->second;
+				else
+					accounts.insert(entry.first);
+			}
+
+			for (Requests::value_type& entry: m_requests)
+			{
+				SocialRequest& request = entry.second;
+				const std::string& account = getAccount(request);
+
+				std::unordered_map<std::string, Json::Value>::const_iterator it = shown.find(account);
+
+				if (it != shown.end())
+					request.m_profile = it->second;
+				else if (request.m_type == SocialRequest::Type::account)
+					accounts.insert(account);
+			}
+
+			fetchProfiles(accounts);
+			changed();
+		}
+
+		m_fetchedConnections.clear();
+		m_fetchedRequests.clear();
+
+		std::vector<Callback> callbacks;
+		callbacks.swap(m_syncCallbacks);
+
+		for (const Callback& callback: callbacks)
+		{
+			callback(*this, m_fetchResult);
+		}
+	}
+
+	void SocialGraph::fetchProfiles(const std::set<std::string>& accounts)
+	{
+		if (accounts.empty() || !AnthillRuntime::IsInstanceValid())
+			return;
+
+		ProfileServicePtr profiles = AnthillRuntime::Instance().get<ProfileService>();
+
+		if (!profiles)
+			return;
+
+		std::weak_ptr<SocialGraph> weak = shared_from_this();
+
+		profiles->getMassProfiles(accounts, m_profileFields, m_accessToken,
+			[weak](const ProfileService& service, Request::Result result, const Request& request, const ProfileService::Profiles& profiles)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (!self || !request.isSuccessful())
+				return;
+
+			for (const ProfileService::Profiles::value_type& entry: profiles)
+			{
+				SocialConnections::iterator connection = self->m_connections.find(entry.first);
+
+				if (connection != self->m_connections.end())
+				{
+					connection->second.m_profile = entry.second;
+				}
+			}
+
+			for (Requests::value_type& entry: self->m_requests)
+			{
+				SocialRequest& request = entry.second;
+				ProfileService::Profiles::const_iterator it = profiles.find(getAccount(request));
+
+				if (it != profiles.end())
+				{
+					request.m_profile = it->second;
+				}
+			}
+
+			self->changed();
+		});
+	}
+
+	const std::string& SocialGraph::getAccount(const SocialRequest& request)
+	{
+		return request.m_kind == SocialRequest::Kind::incoming ? request.m_sender : request.m_object;
+	}
+
+	void SocialGraph::removeRequestTo(const std::string& account)
+	{
+		for (Requests::iterator it = m_requests.begin(); it != m_requests.end();)
+		{
+			if (it->second.m_kind == SocialRequest::Kind::outgoing && it->second.m_object == account)
+			{
+				it = m_requests.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+	}
+
+	bool SocialGraph::handleMessage(const std::string& sender, const std::string& messageType, const Json::Value& payload)
+	{
+		if (messageType == m_policy.incomingRequestType)
+		{
+			SocialRequest request(payload);
+
+			// not enough to keep it, the next sync will bring it in
+			if (request.m_key.empty())
+			{
+				m_stale = true;
+				return true;
+			}
+
+			request.m_kind = SocialRequest::Kind::incoming;
+
+			if (request.m_sender.empty())
+			{
+				request.m_sender = sender;
+			}
+
+			m_requests.erase(request.m_key);
+			m_requests.emplace(request.m_key, request);
+
+			fetchProfiles({ request.m_sender });
+		}
+		else if (messageType == m_policy.approvedType)
+		{
+			removeRequestTo(sender);
+
+			if (m_connections.find(sender) == m_connections.end())
+			{
+				m_connections.emplace(
+					std::piecewise_construct,
+					std::forward_as_tuple(sender),
+					std::forward_as_tuple(payload));
+
+				fetchProfiles({ sender });
+			}
+		}
+		else if (messageType == m_policy.rejectedType)
+		{
+			removeRequestTo(sender);
+		}
+		else if (messageType == m_policy.deletedType)
+		{
+			m_connections.erase(sender);
+		}
+		else
+		{
+			return false;
+		}
+
+		changed();
+		return true;
+	}
+
+	void SocialGraph::addConnection(const std::string& account, SocialService::AddConnectionsCallback callback,
+		bool approval, const Json::Value& notify, const Json::Value& payload)
+	{
+		SocialServicePtr social = m_social.lock();
+
+		if (!social)
+			return;
+
+		std::weak_ptr<SocialGraph> weak = shared_from_this();
+
+		social->addConnection(account, m_accessToken,
+			[weak, account, approval, callback](const SocialService& service, Request::Result result, const Request& request, const std::string& key)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (self && request.isSuccessful())
+			{
+				// the request key is all there is to know about it, the rest comes with the next sync
+				if (approval && !key.empty())
+				{
+					Json::Value data(Json::objectValue);
+
+					data["type"] = "account";
+					data["kind"] = "outgoing";
+					data["object"] = account;
+					data["key"] = key;
+
+					self->m_requests.erase(key);
+					self->m_requests.emplace(key, SocialRequest(data));
+				}
+				else
+				{
+					// connected right away, or unknown
+					self->m_stale = true;
+				}
+
+				self->changed();
+			}
+
+			callback(service, result, request, key);
+		}, approval, notify, payload);
+	}
+
+	void SocialGraph::deleteConnection(const std::string& account, SocialService::DeleteConnectionsCallback callback,
+		const Json::Value& notify)
+	{
+		SocialServicePtr social = m_social.lock();
+
+		if (!social)
+			return;
+
+		std::weak_ptr<SocialGraph> weak = shared_from_this();
+
+		social->deleteConnection(account, m_accessToken,
+			[weak, account, callback](const SocialService& service, Request::Result result, const Request& request)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (self && request.isSuccessful())
+			{
+				self->m_connections.erase(account);
+				self->changed();
+			}
+
+			callback(service, result, request);
+		}, notify);
+	}
+
+	void SocialGraph::approveConnection(const std::string& account, const std::string& key,
+		SocialService::ApproveConnectionsCallback callback, const Json::Value& notify)
+	{
+		SocialServicePtr social = m_social.lock();
+
+		if (!social)
+			return;
+
+		std::weak_ptr<SocialGraph> weak = shared_from_this();
+
+		social->approveConnection(account, key, m_accessToken,
+			[weak, account, key, callback](const SocialService& service, Request::Result result, const Request& request)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (self && request.isSuccessful())
+			{
+				Json::Value profile;
+
+				Requests::iterator it = self->m_requests.find(key);
+
+				if (it != self->m_requests.end())
+				{
+					profile = it->second.m_profile;
+					self->m_requests.erase(it);
+				}
+
+				if (self->m_connections.find(account) == self->m_connections.end())
+				{
+					SocialConnection& connection = self->m_connections.emplace(
+						std::piecewise_construct,
+						std::forward_as_tuple(account),
+						std::forward_as_tuple(Json::Value(Json::objectValue))).first->second;
+
+					connection.m_profile = profile;
+				}
+
+				self->changed();
+			}
+
+			callback(service, result, request);
+		}, notify);
+	}
+
+	void SocialGraph::rejectConnection(const std::string& account, const std::string& key,
+		SocialService::RejectConnectionsCallback callback, const Json::Value& notify)
+	{
+		SocialServicePtr social = m_social.lock();
+
+		if (!social)
+			return;
+
+		std::weak_ptr<SocialGraph> weak = shared_from_this();
+
+		social->rejectConnection(account, key, m_accessToken,
+			[weak, key, callback](const SocialService& service, Request::Result result, const Request& request)
+		{
+			SocialGraphPtr self = weak.lock();
+
+			if (self && request.isSuccessful())
+			{
+				self->m_requests.erase(key);
+				self->changed();
+			}
+
+			callback(service, result, request);
+		}, notify);
+	}
+
+	SocialGraph::~SocialGraph()
+	{
+		//
+	}
+}
@@ -0,0 +1,442 @@
+
+#include "anthill/StartupPipeline.h"
+#include "anthill/AnthillRuntime.h"
+#include "anthill/Log.h"
+#include "anthill/Utils.h"
+#include "anthill/Storage.h"
+
+#include "anthill/services/DiscoveryService.h"
+#include "anthill/services/EnvironmentService.h"
+#include "anthill/services/LoginService.h"
+
+#include "anthill/states/CheckExternalAuthenticationState.h"
+#include "anthill/states/CheckUserState.h"
+#include "anthill/states/RetryState.h"
+
+#include <json/reader.h>
+#include <json/writer.h>
+#include <algorithm>
+#include <ctime>
+
+namespace online
+{
+	const std::string StartupPipeline::ENVIRONMENT = "environment";
+	const std::string StartupPipeline::DISCOVERY = "discovery";
+	const std::string StartupPipeline::AUTHENTICATION = "authentication";
+
+	StartupPipelinePtr StartupPipeline::Create(const WarmStart& warmStart)
+	{
+		StartupPipelinePtr _object(new StartupPipeline(warmStart));
+		if (!_object->init())
+			return StartupPipelinePtr(nullptr);
+
+		return _object;
+	}
+
+	StartupPipeline::StartupPipeline(const WarmStart& warmStart) :
+		Pipeline("Startup"),
+		m_warmStart(warmStart),
+		m_warmServices(false),
+		m_warmToken(false)
+	{
+		//
+	}
+
+	bool StartupPipeline::init()
+	{
+		if (m_warmStart.enabled)
+		{
+			// goes first, so the login service location is known below
+			loadSnapshot();
+		}
+
+		addStage(ENVIRONMENT, {}, [this](StageDone done) { getEnvironment(done); });
+		addStage(DISCOVERY, {ENVIRONMENT}, [this](StageDone done) { discoverServices(done); });
+
+		// with a known login service, a stored token can be validated while the rest is being discovered
+		std::set<std::string> authenticationDependencies;
+
+		if (!AnthillRuntime::Instance().get<LoginService>())
+		{
+			authenticationDependencies.insert(DISCOVERY);
+		}
+
+		addStage(AUTHENTICATION, authenticationDependencies, [this](StageDone done) { authenticate(done); });
+
+		return true;
+	}
+
+	void StartupPipeline::retry(const std::string& stage, std::function<void()> attempt)
+	{
+		float& retryTime = m_retryTimes[stage];
+		retryTime = retryTime > 0 ? std::min(retryTime * 2.0f, RetryState::MaxRetryTime) : 1.0f;
+
+		Log::get() << "Retrying " << stage << " in " << retryTime << std::endl;
+
+		std::weak_ptr<Pipeline> weak = shared_from_this();
+
+		AnthillRuntime::Instance().getFutures().add(retryTime, [weak, attempt]()
+		{
+			if (weak.lock())
+			{
+				attempt();
+			}
+		});
+	}
+
+	void StartupPipeline::getEnvironment(StageDone done)
+	{
+		if (done && m_warmServices)
+		{
+			const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
+			if (listener)
+			{
+				listener->environmentVariablesReceived(m_snapshot["environment"]);
+			}
+
+			// refresh the snapshot for the next start; issued first, as the pipeline may be released once done
+			getEnvironment(nullptr);
+
+			done(true);
+			return;
+		}
+
+		EnvironmentServicePtr ptr = AnthillRuntime::Instance().get<EnvironmentService>();
+		OnlineAssert((bool)ptr, "Environment service is not initialized!");
+
+		// a background refresh outlives the pipeline's completion, so it holds the pipeline
+		PipelinePtr hold = done ? PipelinePtr() : shared_from_this();
+		std::weak_ptr<Pipeline> weak = shared_from_this();
+
+		ptr->getEnvironmentInfo([this, hold, weak, done](const EnvironmentService& env, Request::Result result, const Request& request,
+			const std::string& discoveryLocation, const EnvironmentInformation& data)
+		{
+			if (!weak.lock())
+				return;
+
+			if (!Request::isSuccessful(result))
+			{
+				Log::get() << "GetEnvironmentInfo failed: " << result << ": " << request.getResponseAsString() << std::endl;
+
+				// the snapshot is still good enough, the next start will try again
+				if (!done)
+					return;
+
+				retry(ENVIRONMENT, [this, done]() { getEnvironment(done); });
+				return;
+			}
+
+			AnthillRuntime& online = AnthillRuntime::Instance();
+			online.get<EnvironmentService>()->setDiscoveryLocation(discoveryLocation);
+
+			m_snapshot["environment"] = data;
+			m_snapshot["discovery"] = discoveryLocation;
+
+			if (!done)
+			{
+				discoverServices(nullptr);
+				return;
+			}
+
+			const ListenerPtr& listener = online.getListener();
+			if (listener)
+			{
+				listener->environmentVariablesReceived(data);
+			}
+
+			done(true);
+		});
+	}
+
+	void StartupPipeline::discoverServices(StageDone done)
+	{
+		if (done && m_warmServices)
+		{
+			const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
+
+			if (listener)
+			{
+				listener->servicesDiscovered([done]()
+				{
+					done(true);
+				});
+			}
+			else
+			{
+				done(true);
+			}
+
+			return;
+		}
+
+		DiscoveryServicePtr ptr = AnthillRuntime::Instance().get<DiscoveryService>();
+		OnlineAssert((bool)ptr, "Discovery service is not initialized!");
+
+		PipelinePtr hold = done ? PipelinePtr() : shared_from_this();
+		std::weak_ptr<Pipeline> weak = shared_from_this();
+
+		ptr->discoverServices(AnthillRuntime::Instance().getEnabledServices(),
+			[this, hold, weak, done](const DiscoveryService&, Request::Result result, const Request& request, const DiscoveredServices& services)
+		{
+			if (!weak.lock())
+				return;
+
+			if (!Request::isSuccessful(result))
+			{
+				Log::get() << "DiscoverServices failed: " << result << ": " << request.getResponseAsString() << std::endl;
+
+				if (!done)
+					return;
+
+				retry(DISCOVERY, [this, done]() { discoverServices(done); });
+				return;
+			}
+
+			Json::Value locations(Json::objectValue);
+
+			for (DiscoveredServices::const_iterator it = services.begin(); it != services.end(); it++)
+			{
+				locations[it->first] = it->second->getLocation();
+			}
+
+			m_snapshot["services"] = locations;
+			m_snapshot["services_saved"] = (Json::Int64)std::time(nullptr);
+			saveSnapshot();
+
+			if (!done)
+				return;
+
+			const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
+
+			if (listener)
+			{
+				listener->servicesDiscovered([done]()
+				{
+					done(true);
+				});
+			}
+			else
+			{
+				done(true);
+			}
+		});
+	}
+
+	void StartupPipeline::authenticate(StageDone done)
+	{
+		if (m_warmToken)
+		{
+			const Json::Value& token = m_snapshot["token"];
+
+			LoginServicePtr ptr = AnthillRuntime::Instance().get<LoginService>();
+			OnlineAssert((bool)ptr, "Login service is not initialized!");
+
+			LoginService::Scopes scopes;
+
+			for (const Json::Value& scope : token["scopes"])
+			{
+				scopes.insert(scope.asString());
+			}
+
+			ptr->setCurrentAccessToken(token["access_token"].asString());
+			ptr->setCurrentAccount(token["account"].asString(), token["credential"].asString(), scopes);
+
+			const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
+
+			if (listener)
+			{
+				listener->authenticated(token["account"].asString(), token["credential"].asString(), scopes);
+			}
+
+			revalidateToken();
+
+			done(true);
+			return;
+		}
+
+		m_authentication = StateMachine::Create("Authentication");
+
+		m_authentication->setOnComplete([this, done]()
+		{
+			rememberToken();
+			done(true);
+		});
+
+		m_authentication->switchTo<CheckExternalAuthenticationState>();
+	}
+
+	std::string StartupPipeline::getSnapshotVersion() const
+	{
+		// a snapshot of some other build or environment is of no use
+		AnthillRuntime& online = AnthillRuntime::Instance();
+		const ApplicationInfo& applicationInfo = online.getApplicationInfo();
+
+		return applicationInfo.gamespace + "/" + applicationInfo.applicationName + "/" +
+			applicationInfo.applicationVersion + "/" + online.get<EnvironmentService>()->getLocation() + "/" +
+			join(online.getEnabledServices(), ",");
+	}
+
+	void StartupPipeline::loadSnapshot()
+	{
+		AnthillRuntime& online = AnthillRuntime::Instance();
+		const StoragePtr& storage = online.getStorage();
+
+		if (!storage->has(Storage::StorageStartupSnapshotField))
+			return;
+
+		Json::Value snapshot;
+		Json::Reader reader;
+
+		if (!reader.parse(storage->get(Storage::StorageStartupSnapshotField), snapshot) || !snapshot.isObject() ||
+			snapshot["version"].asString() != getSnapshotVersion())
+		{
+			Log::get() << "Startup snapshot is outdated" << std::endl;
+			return;
+		}
+
+		std::time_t now = std::time(nullptr);
+		const Json::Value& services = snapshot["services"];
+
+		if (!services.isObject() || !snapshot["discovery"].isString() ||
+			now - (std::time_t)snapshot["services_saved"].asInt64() > m_warmStart.servicesTTL)
+		{
+			Log::get() << "Startup snapshot has expired" << std::endl;
+			return;
+		}
+
+		m_snapshot = snapshot;
+		m_warmServices = true;
+
+		online.get<EnvironmentService>()->setDiscoveryLocation(snapshot["discovery"].asString());
+
+		for (Json::ValueConstIterator it = services.begin(); it != services.end(); it++)
+		{
+			online.SetService(it.name(), (*it).asString());
+		}
+
+		const Json::Value& token = snapshot["token"];
+
+		// the token is only trusted if it's the one still in use, and it has been validated recently
+		if (token.isObject() &&
+			storage->has(Storage::StorageAccessTokeneField) &&
+			storage->get(Storage::StorageAccessTokeneField) == token["access_token"].asString() &&
+			now - (std::time_t)token["validated"].asInt64() <= m_warmStart.tokenTTL &&
+			online.get<LoginService>())
+		{
+			m_warmToken = true;
+		}
+
+		Log::get() << "Warm start from a snapshot" << (m_warmToken ? " with a token" : "") << std::endl;
+	}
+
+	void StartupPipeline::saveSnapshot()
+	{
+		if (!m_warmStart.enabled)
+			return;
+
+		m_snapshot["version"] = getSnapshotVersion();
+
+		// nothing to start from yet
+		if (!m_snapshot.isMember("services"))
+			return;
+
+		Json::FastWriter writer;
+
+		const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+		storage->set(Storage::StorageStartupSnapshotField, writer.write(m_snapshot));
+		storage->save();
+	}
+
+	void StartupPipeline::rememberToken()
+	{
+		if (!m_warmStart.enabled)
+			return;
+
+		LoginServicePtr ptr = AnthillRuntime::Instance().get<LoginService>();
+
+		if (!ptr || ptr->getCurrentAccessToken().empty() || ptr->getCurrentAccount().empty())
+			return;
+
+		// the authentication has just validated it, no need to ask again
+		storeToken(ptr->getCurrentAccessToken(), ptr->getCurrentCredential(), ptr->getCurrentAccount(),
+			ptr->getCurrentScopes());
+	}
+
+	void StartupPipeline::storeToken(const std::string& accessToken, const std::string& credential,
+		const std::string& account, const LoginService::Scopes& scopes)
+	{
+		Json::Value token(Json::objectValue);
+		Json::Value& scopesValue = token["scopes"] = Json::Value(Json::arrayValue);
+
+		for (const std::string& scope : scopes)
+		{
+			scopesValue.append(scope);
+		}
+
+		token["access_token"] = accessToken;
+		token["account"] = account;
+		token["credential"] = credential;
+		token["validated"] = (Json::Int64)std::time(nullptr);
+
+		m_snapshot["token"] = token;
+		saveSnapshot();
+	}
+
+	void StartupPipeline::revalidateToken()
+	{
+		LoginServicePtr ptr = AnthillRuntime::Instance().get<LoginService>();
+		OnlineAssert((bool)ptr, "Login service is not initialized!");
+
+		std::string accessToken = ptr->getCurrentAccessToken();
+		// runs after the pipeline is done, so it holds the pipeline
+		PipelinePtr self = shared_from_this();
+
+		ptr->validateAccessToken(accessToken, [this, self, accessToken](const LoginService& service, Request::Result result, const Request& request,
+			const std::string& credential, const std::string& account, const LoginService::Scopes& scopes)
+		{
+			AnthillRuntime& online = AnthillRuntime::Instance();
+			const AccessScopes& shouldHaveScopes = online.getApplicationInfo().shouldHaveScopes;
+
+			if (request.isSuccessful() &&
+				std::includes(scopes.begin(), scopes.end(), shouldHaveScopes.begin(), shouldHaveScopes.end()))
+			{
+				storeToken(accessToken, credential, account, scopes);
+				return;
+			}
+
+			m_snapshot.removeMember("token");
+			saveSnapshot();
+
+			// a network failure does not make the token any less valid
+			if (!m_warmToken || result == Request::CONNECTION_ERROR || result >= Request::INTERNAL_ERROR)
+				return;
+
+			Log::get() << "Snapshot access token is invalid, authenticating again" << std::endl;
+
+			m_warmToken = false;
+
+			const StoragePtr& storage = online.getStorage();
+			storage->remove(Storage::StorageAccessTokeneField);
+			storage->save();
+
+			m_authentication = StateMachine::Create("Authentication");
+			m_authentication->setOnComplete([this, self]()
+			{
+				rememberToken();
+
+				// let go of the pipeline, not from within the machine's own callback
+				AnthillRuntime::Instance().getFutures().postNextUpdate([this, self]()
+				{
+					m_authentication.reset();
+				});
+			});
+
+			m_authentication->switchTo<CheckUserState>();
+		});
+	}
+
+	StartupPipeline::~StartupPipeline()
+	{
+		//
+	}
+}
@@ -7,4 +7,8 @@ namespace online
 	const std::string Storage::StorageUsernameField = "online-username";
 	const std::string Storage::StoragePasswordField = "online-password";
 	const std::string Storage::StorageAccessTokeneField = "online-access-token";
+	const std::string Storage::StorageStartupSnapshotField = "online-startup-snapshot";
+	const std::string Storage::StoragePendingScoresField = "online-pending-scores";
+	const std::string Storage::StorageStoreCatalogField = "online-store-catalog-";
+	const std::string Storage::StorageBundlesField = "online-bundles";
 }
@@ -0,0 +1,223 @@
+#include "anthill/StoreCatalog.h"
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace online
+{
+	const StoreCatalog::Index StoreCatalog::NONE = std::numeric_limits<StoreCatalog::Index>::max();
+
+	StoreCatalogPtr StoreCatalog::Create(const std::string& name, const Json::Value& data)
+	{
+		StoreCatalogPtr _object(new StoreCatalog(name));
+		if (!_object->init(data))
+			return StoreCatalogPtr(nullptr);
+
+		return _object;
+	}
+
+	StoreCatalog::StoreCatalog(const std::string& name) :
+		m_name(name)
+	{
+		//
+	}
+
+	StoreCatalog::StringId StoreCatalog::intern(const std::string& value)
+	{
+		std::unordered_map<std::string, StringId>::iterator it = m_stringIds.find(value);
+
+		if (it != m_stringIds.end())
+			return it->second;
+
+		StringId id = (StringId)m_strings.size();
+
+		m_strings.push_back(value);
+		m_stringIds.emplace(value, id);
+
+		return id;
+	}
+
+	StoreCatalog::StringId StoreCatalog::find(const std::string& value) const
+	{
+		std::unordered_map<std::string, StringId>::const_iterator it = m_stringIds.find(value);
+		return it != m_stringIds.end() ? it->second : NONE;
+	}
+
+	bool StoreCatalog::init(const Json::Value& data)
+	{
+		if (!data.isObject() || !data["store"].isObject())
+			return false;
+
+		const Json::Value& store = data["store"];
+		const Json::Value& tiers = store["tiers"];
+		const Json::Value& items = store["items"];
+
+		// the empty string is always 0, for the fields that are not there
+		intern("");
+
+		if (tiers.isObject())
+		{
+			m_tiers.reserve(tiers.size());
+
+			for (Json::ValueConstIterator it = tiers.begin(); it != tiers.end(); it++)
+			{
+				const Json::Value& value = *it;
+				const Json::Value& prices = value["prices"];
+
+				Tier tier;
+
+				tier.name = intern(it.name());
+				tier.product = intern(value["product"].asString());
+				tier.firstPrice = (Index)m_prices.size();
+				tier.prices = 0;
+
+				if (prices.isObject())
+				{
+					for (Json::ValueConstIterator p = prices.begin(); p != prices.end(); p++)
+					{
+						const Json::Value& entry = *p;
+
+						Price price;
+
+						price.currency = intern(p.name());
+						price.format = intern(entry["format"].asString());
+						price.title = intern(entry["title"].asString());
+						price.symbol = intern(entry["symbol"].asString());
+						price.label = intern(entry["label"].asString());
+						price.price = entry["price"].asInt();
+
+						m_prices.push_back(price);
+						tier.prices++;
+					}
+				}
+
+				m_tiersByName.emplace(tier.name, (Index)m_tiers.size());
+				m_tiers.push_back(tier);
+			}
+		}
+
+		if (items.isArray())
+		{
+			m_items.reserve(items.size());
+			m_payloads.reserve(items.size());
+			m_options.reserve(items.size());
+
+			for (const Json::Value& value: items)
+			{
+				const Json::Value& billing = value["billing"];
+				const std::string type = billing["type"].asString();
+
+				Item item;
+
+				item.id = intern(value["id"].asString());
+				item.category = intern(value["category"].asString());
+				item.billing = Billing::None;
+				item.tier = NONE;
+				item.currency = 0;
+				item.amount = 0;
+
+				if (type == "iap")
+				{
+					item.billing = Billing::IAP;
+
+					std::unordered_map<StringId, Index>::const_iterator tier =
+						m_tiersByName.find(find(billing["tier"].asString()));
+
+					if (tier != m_tiersByName.end())
+					{
+						item.tier = tier->second;
+					}
+				}
+				else if (type == "offline")
+				{
+					item.billing = Billing::Offline;
+					item.currency = intern(billing["currency"].asString());
+					item.amount = billing["amount"].asInt();
+				}
+
+				Index index = (Index)m_items.size();
+
+				m_itemsById.emplace(item.id, index);
+				m_categories[item.category].push_back(index);
+
+				m_items.push_back(item);
+				m_payloads.push_back(value["public"]);
+				m_options.push_back(value["options"]);
+			}
+		}
+
+		return true;
+	}
+
+	const StoreCatalog::Item* StoreCatalog::findItem(const std::string& id) const
+	{
+		std::unordered_map<StringId, Index>::const_iterator it = m_itemsById.find(find(id));
+		return it != m_itemsById.end() ? &m_items[it->second] : nullptr;
+	}
+
+	const std::vector<StoreCatalog::Index>& StoreCatalog::getCategory(const std::string& category) const
+	{
+		static const std::vector<Index> empty;
+
+		std::unordered_map<StringId, std::vector<Index> >::const_iterator it = m_categories.find(find(category));
+		return it != m_categories.end() ? it->second : empty;
+	}
+
+	std::vector<std::string> StoreCatalog::getCategories() const
+	{
+		std::vector<std::string> result;
+		result.reserve(m_categories.size());
+
+		for (const std::unordered_map<StringId, std::vector<Index> >::value_type& entry: m_categories)
+		{
+			result.push_back(m_strings[entry.first]);
+		}
+
+		return result;
+	}
+
+	const StoreCatalog::Tier* StoreCatalog::findTier(const std::string& name) const
+	{
+		std::unordered_map<StringId, Index>::const_iterator it = m_tiersByName.find(find(name));
+		return it != m_tiersByName.end() ? &m_tiers[it->second] : nullptr;
+	}
+
+	const StoreCatalog::Tier* StoreCatalog::getTier(const Item& item) const
+	{
+		return item.tier != NONE ? &m_tiers[item.tier] : nullptr;
+	}
+
+	const StoreCatalog::Price* StoreCatalog::findPrice(const Tier& tier, const std::string& currency) const
+	{
+		StringId id = find(currency);
+
+		if (id == NONE)
+			return nullptr;
+
+		for (Index i = tier.firstPrice; i < tier.firstPrice + tier.prices; i++)
+		{
+			if (m_prices[i].currency == id)
+				return &m_prices[i];
+		}
+
+		return nullptr;
+	}
+
+	std::string StoreCatalog::getFormattedPrice(const Price& price, int amount) const
+	{
+		std::ostringstream priceWithPrecision;
+		priceWithPrecision << std::setprecision(2);
+		priceWithPrecision << (price.price / 100.0f) * (float)amount;
+
+		const std::string& format = m_strings[price.format];
+
+		size_t plugPos = format.find("{0}");
+		if (plugPos == std::string::npos)
+			return priceWithPrecision.str();
+
+		std::string result = format;
+		result.replace(plugPos, 3, priceWithPrecision.str());
+		return result;
+	}
+}
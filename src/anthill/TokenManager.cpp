@@ -0,0 +1,239 @@
+#include "anthill/TokenManager.h"
+#include "anthill/AnthillRuntime.h"
+#include "anthill/Log.h"
+#include "anthill/Utils.h"
+
+#include "anthill/services/LoginService.h"
+
+#include <json/reader.h>
+#include <sstream>
+
+namespace online
+{
+	TokenManagerPtr TokenManager::Create()
+	{
+		TokenManagerPtr _object(new TokenManager());
+		if (!_object->init())
+			return TokenManagerPtr(nullptr);
+
+		return _object;
+	}
+
+	TokenManager::TokenManager() :
+		m_expiresAt(0),
+		m_lastRefresh(0),
+		m_nextAttempt(0),
+		m_refreshing(false)
+	{
+		//
+	}
+
+	bool TokenManager::init()
+	{
+		return true;
+	}
+
+	void TokenManager::tokenChanged(const std::string& accessToken)
+	{
+		m_accessToken = accessToken;
+		m_expiresAt = 0;
+		m_nextAttempt = 0;
+		m_scopes.clear();
+
+		// the token is a JWT, its payload (the second part) has got the expiration time and the scopes
+		size_t first = accessToken.find('.');
+		size_t second = first == std::string::npos ? std::string::npos : accessToken.find('.', first + 1);
+
+		if (second == std::string::npos)
+			return;
+
+		Json::Value payload;
+
+		if (!Json::Reader().parse(base64_decode(accessToken.substr(first + 1, second - first - 1)), payload) ||
+			!payload.isObject())
+		{
+			return;
+		}
+
+		if (payload["exp"].isNumeric())
+		{
+			m_expiresAt = (std::time_t)payload["exp"].asInt64();
+		}
+
+		if (payload["sc"].isString())
+		{
+			std::stringstream scopes(payload["sc"].asString());
+			std::string scope;
+
+			while (std::getline(scopes, scope, ','))
+			{
+				if (!scope.empty())
+				{
+					m_scopes.insert(scope);
+				}
+			}
+		}
+	}
+
+	void TokenManager::update()
+	{
+		LoginServicePtr login = AnthillRuntime::Instance().get<LoginService>();
+
+		if (!login)
+			return;
+
+		const std::string& accessToken = login->getCurrentAccessToken();
+
+		if (accessToken != m_accessToken)
+		{
+			tokenChanged(accessToken);
+		}
+
+		if (!m_policy.enabled || m_refreshing || m_accessToken.empty() || m_expiresAt == 0)
+			return;
+
+		std::time_t now = get_utc_timestamp();
+
+		if (now >= m_expiresAt - m_policy.refreshAhead && now >= m_nextAttempt)
+		{
+			refresh();
+		}
+	}
+
+	void TokenManager::refresh()
+	{
+		if (m_refreshing || m_accessToken.empty())
+			return;
+
+		AnthillRuntime& online = AnthillRuntime::Instance();
+		LoginServicePtr login = online.get<LoginService>();
+
+		if (!login)
+			return;
+
+		m_refreshing = true;
+		m_lastRefresh = get_utc_timestamp();
+
+		std::string accessToken = m_accessToken;
+		const LoginService::Scopes& scopes = m_scopes.empty() ? online.getApplicationInfo().requiredScopes : m_scopes;
+
+		Log::get() << "Refreshing the access token" << std::endl;
+
+		login->extend(accessToken, accessToken, scopes, [this, accessToken](const LoginService& service, Request::Result result, const Request& request,
+			const std::string& newToken, const std::string& credential, const std::string& account, const LoginService::Scopes& scopes)
+		{
+			m_refreshing = false;
+
+			AnthillRuntime& online = AnthillRuntime::Instance();
+			LoginServicePtr login = online.get<LoginService>();
+
+			// the token has been replaced by someone else meanwhile
+			if (!login || login->getCurrentAccessToken() != accessToken)
+			{
+				replayPending();
+				return;
+			}
+
+			if (!request.isSuccessful() || newToken.empty())
+			{
+				Log::get() << "Failed to refresh the access token: " << result << ": " << request.getResponseAsString() << std::endl;
+
+				m_nextAttempt = get_utc_timestamp() + m_policy.retryInterval;
+				completePending();
+				return;
+			}
+
+			Log::get() << "Access token refreshed" << std::endl;
+
+			login->setCurrentAccessToken(newToken);
+
+			const StoragePtr& storage = online.getStorage();
+			storage->set(Storage::StorageAccessTokeneField, newToken);
+			storage->save();
+
+			tokenChanged(newToken);
+			replayPending();
+		});
+	}
+
+	bool TokenManager::intercept(const RequestPtr& request)
+	{
+		if (!m_policy.enabled || m_accessToken.empty())
+			return false;
+
+		std::string accessToken = request->getAccessToken();
+
+		if (accessToken.empty())
+			return false;
+
+		AnthillRuntime& online = AnthillRuntime::Instance();
+		LoginServicePtr login = online.get<LoginService>();
+
+		// the login service answers about the token itself, there's nothing to replay
+		if (!login || request->m_location.compare(0, login->getLocation().size(), login->getLocation()) == 0)
+			return false;
+
+		if (!m_refreshing && accessToken == m_accessToken)
+		{
+			std::time_t now = get_utc_timestamp();
+
+			bool expiring = m_expiresAt != 0 && now >= m_expiresAt - m_policy.refreshAhead;
+			bool suspicious = request->getResult() == Request::UNAUTHORIZED ||
+				(m_expiresAt == 0 && now >= m_lastRefresh + m_policy.minRefreshInterval);
+
+			if (!expiring && !suspicious)
+				return false;
+
+			m_pending.push_back(request);
+			refresh();
+
+			return true;
+		}
+
+		m_pending.push_back(request);
+
+		// made with an older token while a new one has been in place already
+		if (!m_refreshing)
+		{
+			replayPending();
+		}
+
+		return true;
+	}
+
+	void TokenManager::replayPending()
+	{
+		std::list<RequestPtr> pending;
+		pending.swap(m_pending);
+
+		std::string accessToken = m_accessToken;
+
+		// the requests are still being finished by the runtime, so they're started again on the next update
+		AnthillRuntime::Instance().getFutures().postNextUpdate([pending, accessToken]()
+		{
+			for (const RequestPtr& request : pending)
+			{
+				if (!request->replay(accessToken))
+				{
+					request->complete();
+				}
+			}
+		});
+	}
+
+	void TokenManager::completePending()
+	{
+		std::list<RequestPtr> pending;
+		pending.swap(m_pending);
+
+		for (const RequestPtr& request : pending)
+		{
+			request->complete();
+		}
+	}
+
+	TokenManager::~TokenManager()
+	{
+		//
+	}
+}
@@ -0,0 +1,213 @@
+#include "anthill/Tracing.h"
+#include "anthill/Log.h"
+
+#include <json/writer.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace online
+{
+	static thread_local Tracer::SpanId s_current = 0;
+
+	static unsigned int currentThread()
+	{
+		static std::atomic<unsigned int> nextThread(1);
+		static thread_local unsigned int thread = nextThread++;
+
+		return thread;
+	}
+
+	Tracer::Scope::Scope(SpanId span) :
+		m_previous(s_current)
+	{
+		if (span)
+		{
+			s_current = span;
+		}
+	}
+
+	Tracer::Scope::~Scope()
+	{
+		s_current = m_previous;
+	}
+
+	Tracer::Span::Span(const char* category, const std::string& name) :
+		m_id(Tracer::get().begin(category, name)),
+		m_scope(m_id)
+	{
+		//
+	}
+
+	Tracer::Span::~Span()
+	{
+		Tracer::get().end(m_id);
+	}
+
+	Tracer& Tracer::get()
+	{
+		static Tracer instance;
+		return instance;
+	}
+
+	Tracer::Tracer() :
+		m_enabled(false),
+		m_nextId(1),
+		m_epoch(Clock::now()),
+		m_capacity(1000000),
+		m_dropped(0)
+	{
+		//
+	}
+
+	int64_t Tracer::now() const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_epoch).count();
+	}
+
+	Tracer::SpanId Tracer::getCurrent()
+	{
+		return s_current;
+	}
+
+	void Tracer::record(Event&& event)
+	{
+		if (m_events.size() >= m_capacity)
+		{
+			m_dropped++;
+			return;
+		}
+
+		m_events.push_back(std::move(event));
+	}
+
+	Tracer::SpanId Tracer::begin(const char* category, const std::string& name, const Json::Value& args)
+	{
+		if (!isEnabled())
+			return 0;
+
+		Event event;
+
+		event.m_phase = 'b';
+		event.m_category = category;
+		event.m_name = name;
+		event.m_id = m_nextId++;
+		event.m_parent = s_current;
+		event.m_timestamp = now();
+		event.m_thread = currentThread();
+		event.m_args = args;
+
+		SpanId id = event.m_id;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// a span that never ends is forgotten, the oldest first, rather than kept forever
+		if (m_open.size() >= MAX_OPEN_SPANS)
+		{
+			m_open.erase(m_open.begin());
+			m_dropped++;
+		}
+
+		OpenSpan open = { id, category, name };
+		m_open.push_back(open);
+
+		record(std::move(event));
+		return id;
+	}
+
+	void Tracer::end(SpanId span, const Json::Value& args)
+	{
+		if (!span)
+			return;
+
+		int64_t timestamp = now();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// the open spans are few and the recent ones end first
+		std::vector<OpenSpan>::reverse_iterator it = std::find_if(m_open.rbegin(), m_open.rend(),
+			[span](const OpenSpan& open) { return open.m_id == span; });
+
+		if (it == m_open.rend())
+			return;
+
+		Event event;
+
+		event.m_phase = 'e';
+		event.m_category = it->m_category;
+		event.m_name = std::move(it->m_name);
+		event.m_id = span;
+		event.m_parent = 0;
+		event.m_timestamp = timestamp;
+		event.m_thread = currentThread();
+		event.m_args = args;
+
+		m_open.erase(std::next(it).base());
+
+		record(std::move(event));
+	}
+
+	bool Tracer::save(const std::string& path)
+	{
+		Json::Value events(Json::arrayValue);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			for (const Event& event : m_events)
+			{
+				Json::Value& value = events.append(Json::Value(Json::objectValue));
+
+				std::stringstream id;
+				id << "0x" << std::hex << event.m_id;
+
+				value["ph"] = std::string(1, event.m_phase);
+				value["cat"] = event.m_category;
+				value["name"] = event.m_name;
+				value["id"] = id.str();
+				value["ts"] = (Json::Int64)event.m_timestamp;
+				value["pid"] = 1;
+				value["tid"] = event.m_thread;
+
+				Json::Value args = event.m_args.isObject() ? event.m_args : Json::Value(Json::objectValue);
+
+				if (event.m_phase == 'b')
+				{
+					args["span"] = (Json::UInt64)event.m_id;
+					args["parent"] = (Json::UInt64)event.m_parent;
+				}
+
+				value["args"] = args;
+			}
+
+			if (m_dropped)
+			{
+				Log::get() << "Tracer: " << m_dropped << " events were dropped" << std::endl;
+			}
+		}
+
+		Json::Value trace(Json::objectValue);
+		trace["traceEvents"] = events;
+		trace["displayTimeUnit"] = "ms";
+
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		file << Json::FastWriter().write(trace);
+
+		if (!file.good())
+		{
+			Log::get() << "Tracer: failed to write " << path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void Tracer::clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_events.clear();
+		m_dropped = 0;
+	}
+}
@@ -0,0 +1,311 @@
+#include "anthill/TrackedProfile.h"
+#include "anthill/AnthillRuntime.h"
+#include "anthill/Log.h"
+
+namespace online
+{
+	static const Json::Value* resolve(const Json::Value& profile, const std::string& path)
+	{
+		const Json::Value* value = &profile;
+		size_t start = 0;
+
+		while (value && start < path.size())
+		{
+			size_t end = path.find('/', start);
+			if (end == std::string::npos)
+				end = path.size();
+
+			value = value->isObject() && value->isMember(path.substr(start, end - start)) ?
+				&(*value)[path.substr(start, end - start)] : nullptr;
+
+			start = end + 1;
+		}
+
+		return value;
+	}
+
+	static Json::Value& make(Json::Value& profile, const std::string& path)
+	{
+		Json::Value* value = &profile;
+		size_t start = 0;
+
+		while (start < path.size())
+		{
+			size_t end = path.find('/', start);
+			if (end == std::string::npos)
+				end = path.size();
+
+			if (!value->isObject())
+			{
+				*value = Json::Value(Json::objectValue);
+			}
+
+			value = &(*value)[path.substr(start, end - start)];
+			start = end + 1;
+		}
+
+		return *value;
+	}
+
+	// "a" covers "a/b"
+	static bool covers(const std::string& parent, const std::string& path)
+	{
+		return parent.empty() || (path.size() > parent.size() &&
+			path.compare(0, parent.size(), parent) == 0 && path[parent.size()] == '/');
+	}
+
+	TrackedProfilePtr TrackedProfile::Create(const ProfileServicePtr& service, const std::string& accessToken,
+		const std::string& account, float interval)
+	{
+		TrackedProfilePtr _object(new TrackedProfile(service, accessToken, account, interval));
+		if (!_object->init())
+			return TrackedProfilePtr(nullptr);
+
+		return _object;
+	}
+
+	TrackedProfile::TrackedProfile(const ProfileServicePtr& service, const std::string& accessToken,
+		const std::string& account, float interval) :
+		m_service(service),
+		m_accessToken(accessToken),
+		m_account(account),
+		m_interval(interval),
+		m_profile(Json::objectValue),
+		m_scheduled(false),
+		m_sending(false)
+	{
+		//
+	}
+
+	bool TrackedProfile::init()
+	{
+		return !m_service.expired();
+	}
+
+	const Json::Value& TrackedProfile::get(const std::string& path) const
+	{
+		static const Json::Value null;
+
+		const Json::Value* value = resolve(m_profile, path);
+		return value ? *value : null;
+	}
+
+	void TrackedProfile::set(const std::string& path, const Json::Value& value)
+	{
+		Json::Value& target = make(m_profile, path);
+
+		if (target == value)
+			return;
+
+		target = value;
+
+		// a change under a path that is dirty already is sent with it
+		for (const std::string& dirty: m_dirty)
+		{
+			if (dirty == path || covers(dirty, path))
+				return;
+		}
+
+		for (std::set<std::string>::iterator it = m_dirty.begin(); it != m_dirty.end();)
+		{
+			if (covers(path, *it))
+			{
+				it = m_dirty.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+
+		m_dirty.insert(path);
+		schedule();
+	}
+
+	void TrackedProfile::schedule()
+	{
+		if (m_scheduled || m_sending || m_dirty.empty())
+			return;
+
+		m_scheduled = true;
+
+		std::weak_ptr<TrackedProfile> weak = shared_from_this();
+
+		AnthillRuntime::Instance().getFutures().add(m_interval, [weak]()
+		{
+			TrackedProfilePtr self = weak.lock();
+
+			if (self && self->m_scheduled)
+			{
+				self->m_scheduled = false;
+				self->send();
+			}
+		});
+	}
+
+	void TrackedProfile::flush(Callback callback)
+	{
+		if (callback)
+		{
+			if (m_dirty.empty() && !m_sending)
+			{
+				callback(*this, Request::SUCCESS);
+				return;
+			}
+
+			// nothing new to send, it's done once the changes in flight are
+			if (m_dirty.empty())
+			{
+				m_sentCallbacks.push_back(callback);
+			}
+			else
+			{
+				m_flushCallbacks.push_back(callback);
+			}
+		}
+
+		// the rest is sent as soon as the one in flight is done
+		if (m_sending)
+			return;
+
+		m_scheduled = false;
+		send();
+	}
+
+	Json::Value TrackedProfile::buildPatch(const std::set<std::string>& paths) const
+	{
+		Json::Value patch(Json::objectValue);
+
+		for (const std::string& path: paths)
+		{
+			const Json::Value* value = resolve(m_profile, path);
+			make(patch, path) = value ? *value : Json::Value();
+		}
+
+		return patch;
+	}
+
+	void TrackedProfile::applyDirty(Json::Value& profile) const
+	{
+		for (const std::string& path: m_dirty)
+		{
+			const Json::Value* value = resolve(m_profile, path);
+			make(profile, path) = value ? *value : Json::Value();
+		}
+	}
+
+	void TrackedProfile::send()
+	{
+		ProfileServicePtr service = m_service.lock();
+
+		if (!service || m_dirty.empty())
+			return;
+
+		m_sending = true;
+		m_sent.swap(m_dirty);
+
+		// these wait for exactly the changes being sent now
+		m_sentCallbacks.insert(m_sentCallbacks.end(), m_flushCallbacks.begin(), m_flushCallbacks.end());
+		m_flushCallbacks.clear();
+
+		Json::Value patch = buildPatch(m_sent);
+		std::weak_ptr<TrackedProfile> weak = shared_from_this();
+
+		service->setProfile(m_account, "", patch, true, m_accessToken,
+			[weak](const ProfileService& service, Request::Result result, const Request& request, const Json::Value& profile)
+		{
+			TrackedProfilePtr self = weak.lock();
+
+			if (!self)
+				return;
+
+			self->m_sending = false;
+
+			if (request.isSuccessful())
+			{
+				// what the server has got is the truth, with whatever's been changed since on top
+				Json::Value confirmed = profile.isObject() ? profile : Json::Value(Json::objectValue);
+				self->applyDirty(confirmed);
+				self->m_profile = confirmed;
+			}
+			else
+			{
+				Log::get() << "Failed to save the profile: " << result << ": " << request.getResponseAsString() << std::endl;
+
+				// tried again along with the next changes
+				for (const std::string& path: self->m_sent)
+				{
+					self->m_dirty.insert(path);
+				}
+			}
+
+			self->m_sent.clear();
+
+			std::vector<Callback> callbacks;
+			callbacks.swap(self->m_sentCallbacks);
+
+			for (const Callback& callback: callbacks)
+			{
+				callback(*self, result);
+			}
+
+			if (self->m_onSynced)
+			{
+				self->m_onSynced(*self, result);
+			}
+
+			// flushed while this one was in flight, those changes go now
+			if (!self->m_flushCallbacks.empty() && !self->m_sending)
+			{
+				self->m_scheduled = false;
+				self->send();
+				return;
+			}
+
+			self->schedule();
+		});
+	}
+
+	void TrackedProfile::load(Callback callback)
+	{
+		ProfileServicePtr service = m_service.lock();
+
+		if (!service)
+			return;
+
+		std::weak_ptr<TrackedProfile> weak = shared_from_this();
+
+		service->getProfile(m_account, "", m_accessToken,
+			[weak, callback](const ProfileService& service, Request::Result result, const Request& request, const Json::Value& profile)
+		{
+			TrackedProfilePtr self = weak.lock();
+
+			if (!self)
+				return;
+
+			if (request.isSuccessful() && Request::isSuccessful(result))
+			{
+				Json::Value loaded = profile.isObject() ? profile : Json::Value(Json::objectValue);
+				self->applyDirty(loaded);
+
+				for (const std::string& path: self->m_sent)
+				{
+					const Json::Value* value = resolve(self->m_profile, path);
+					make(loaded, path) = value ? *value : Json::Value();
+				}
+
+				self->m_profile = loaded;
+			}
+
+			if (callback)
+			{
+				callback(*self, result);
+			}
+		});
+	}
+
+	TrackedProfile::~TrackedProfile()
+	{
+		//
+	}
+}
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cctype>
 #include <iomanip>
+#include <locale>
 #include <string>
 #include <regex>
 
@@ -53,6 +54,25 @@ namespace online
 #endif
     }
 
+    std::time_t parse_http_date(const std::string& date)
+    {
+        std::tm tm = {};
+        
+#if defined( WIN32 ) || defined( _WIN32 )
+        std::stringstream ss(date);
+        // the names of the days and the months are English whatever the locale is
+        ss.imbue(std::locale::classic());
+        ss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+        if (ss.fail())
+            return 0;
+        return _mkgmtime(&tm);
+#else
+        if (!strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S", &tm))
+            return 0;
+        return timegm(&tm);
+#endif
+    }
+
 	std::string dump_time(std::time_t time, bool includeDate, bool local)
 	{
 		std::tm * ptm = local ? std::localtime( &time ) : std::gmtime( &time );
@@ -130,6 +150,39 @@ namespace online
         return data;
     }
 
+    std::string base64_decode(const std::string &value)
+    {
+        std::string result;
+        result.reserve(value.size() * 3 / 4);
+
+        unsigned int buffer = 0;
+        int bits = 0;
+
+        for (char c : value)
+        {
+            int digit;
+
+            if (c >= 'A' && c <= 'Z') digit = c - 'A';
+            else if (c >= 'a' && c <= 'z') digit = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') digit = c - '0' + 52;
+            else if (c == '+' || c == '-') digit = 62;
+            else if (c == '/' || c == '_') digit = 63;
+            else if (c == '=') break;
+            else continue;
+
+            buffer = (buffer << 6) | digit;
+            bits += 6;
+
+            if (bits >= 8)
+            {
+                bits -= 8;
+                result.push_back((char)((buffer >> bits) & 0xFF));
+            }
+        }
+
+        return result;
+    }
+
 	std::string join(const std::set<std::string>& elements, const char* const separator)
 	{
 		switch (elements.size())
@@ -206,6 +259,12 @@ namespace online
 		}
 	}
 
+	std::mt19937& random_engine()
+	{
+		static thread_local std::mt19937 engine(std::random_device{}());
+		return engine;
+	}
+
 	std::string random_string(size_t length)
 	{
 		auto randchar = []() -> char
@@ -215,7 +274,8 @@ namespace online
 				"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 				"abcdefghijklmnopqrstuvwxyz";
 			const size_t max_index = (sizeof(charset) - 1);
-			return charset[rand() % max_index];
+			std::uniform_int_distribution<size_t> index(0, max_index - 1);
+			return charset[index(random_engine())];
 		};
 		std::string str(length, 0);
 		std::generate_n(str.begin(), length, randchar);
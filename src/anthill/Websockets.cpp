@@ -6,99 +6,222 @@
 #include "uv.h"
 #include "anthill/Websockets.h"
 
+#include <cmath>
+
 using namespace std::placeholders;
 
 namespace online
 {
-    WebsocketRPCPtr WebsocketRPC::Create()
+    WebsocketHubPtr WebsocketHub::Create()
+    {
+        return WebsocketHubPtr(new WebsocketHub());
+    }
+    
+    WebsocketHub::WebsocketHub() :
+        m_hub()
+    {
+    }
+    
+    WebsocketHub::~WebsocketHub()
     {
-        return WebsocketRPCPtr(new WebsocketRPC());
+        for (uWS::Group<uWS::CLIENT>* group : m_released)
+        {
+            delete group;
+        }
     }
     
-    WebsocketRPC::WebsocketRPC() :
-        m_connected(false)
+    uWS::Group<uWS::CLIENT>* WebsocketHub::createGroup()
     {
-        m_client.getDefaultGroup<uWS::CLIENT>().onMessage(std::bind(&WebsocketRPC::onMessage, this, _1, _2, _3, _4));
+        return m_hub.createGroup<uWS::CLIENT>();
+    }
+    
+    void WebsocketHub::releaseGroup(uWS::Group<uWS::CLIENT>* group)
+    {
+        // the owner is going away, so nothing should call back into it
+        group->onConnection([](uWS::WebSocket<uWS::CLIENT> *socket, uWS::HttpRequest request) {});
+        group->onDisconnection([](uWS::WebSocket<uWS::CLIENT> *socket, int code, char *message, size_t length) {});
+        group->onMessage([](uWS::WebSocket<uWS::CLIENT> *socket, char *message, size_t length, uWS::OpCode opCode) {});
+        group->onPong([](uWS::WebSocket<uWS::CLIENT> *socket, char *message, size_t length) {});
+        group->onError([](void *user) {});
+        
+        group->terminate();
+        m_released.push_back(group);
+    }
+    
+    void WebsocketHub::connect(const std::string& uri, const std::map<std::string, std::string>& extraHeaders,
+                               uWS::Group<uWS::CLIENT>* group)
+    {
+        m_hub.connect(uri, nullptr, extraHeaders, 5000, group);
+    }
+    
+    void WebsocketHub::update(bool wait)
+    {
+        uv_loop_t* loop = (uv_loop_t*)m_hub.getLoop();
+		if (loop)
+		{
+			uv_run(loop, wait ? UV_RUN_ONCE : UV_RUN_NOWAIT);
+		}
+        
+        if (!m_released.empty())
+        {
+            for (uWS::Group<uWS::CLIENT>* group : m_released)
+            {
+                delete group;
+            }
+            
+            m_released.clear();
+        }
+    }
+    
+    bool WebsocketHub::isAlive()
+    {
+        uv_loop_t* loop = (uv_loop_t*)m_hub.getLoop();
+        return loop && uv_loop_alive(loop);
+    }
+    
+    //////////////////////
+    
+    WebsocketRPCPtr WebsocketRPC::Create(const WebsocketHubPtr& hub)
+    {
+        if (hub)
+        {
+            return WebsocketRPCPtr(new WebsocketRPC(hub, false));
+        }
+        
+        if (AnthillRuntime::IsInstanceValid())
+        {
+            return WebsocketRPCPtr(new WebsocketRPC(AnthillRuntime::Instance().getWebsocketHub(), false));
+        }
+        
+        // no runtime to drive the loop, so this connection runs a private one in its own update
+        return WebsocketRPCPtr(new WebsocketRPC(WebsocketHub::Create(), true));
+    }
+    
+    WebsocketRPC::WebsocketRPC(const WebsocketHubPtr& hub, bool ownsHub) :
+        m_hub(hub),
+        m_group(hub->createGroup()),
+        m_socket(nullptr),
+        m_ownsHub(ownsHub),
+        m_open(false),
+        m_connected(false),
+        m_closing(false),
+        m_reconnectAttempt(0),
+        m_reconnectPending(false),
+        m_random(std::random_device()()),
+        m_pingId(0),
+        m_pingOutstanding(false)
+    {
+        m_group->onMessage(std::bind(&WebsocketRPC::onMessage, this, _1, _2, _3, _4));
+        m_group->onPong(std::bind(&WebsocketRPC::onPong, this, _1, _2, _3));
+        
+        // the server may hand out a token that lets a reconnected socket resume the same session
+        handle("session_resume", [this](const Json::Value& params, JsonRPC::Success success, JsonRPC::Failture failture)
+        {
+            m_resumeToken = params["token"].asString();
+            success(Json::Value(Json::ValueType::objectValue));
+        });
     }
     
     void WebsocketRPC::close()
     {
-        m_client.getDefaultGroup<uWS::CLIENT>().close();
+        stopReconnecting();
+        m_group->close();
     }
     
     void WebsocketRPC::terminate()
     {
-        m_client.getDefaultGroup<uWS::CLIENT>().terminate();
+        stopReconnecting();
+        m_group->terminate();
+    }
+    
+    void WebsocketRPC::stopReconnecting()
+    {
+        // closed on purpose, so the disconnection is not followed by a reconnect
+        m_closing = true;
+        
+        // the socket is gone already, nothing is going to report the disconnection
+        if (m_reconnectPending)
+        {
+            m_reconnectPending = false;
+            m_reconnectAttempt = 0;
+            rejectAllResponseHandlers(1000, "Disconnected", "Closed while reconnecting");
+        }
     }
 		
 	void WebsocketRPC::waitForShutdown()
 	{
-        uv_loop_t* loop = (uv_loop_t*)m_client.getLoop();
-		while (uv_loop_alive(loop))
+        // other connections may keep the shared loop alive, so wait for this one only
+		while (m_open && m_hub->isAlive())
 		{
-			update();
+			m_hub->update(true);
 		}
 	}
     
     WebsocketRPC::~WebsocketRPC()
     {
+        m_hub->releaseGroup(m_group);
     }
     
     void WebsocketRPC::connect(const std::string& location, const Options& options,
                                ConnectCallback onConnect, DisconnectCallback onDisconnect,
                                const std::map<std::string, std::string>& extraHeaders)
     {
-        std::string ws;
-        
-        if (location.find("http://") == 0)
-        {
-            ws = "ws://" + location.substr(7);
-        }
-        else if (location.find("https://") == 0)
-        {
-            ws = "wss://" + location.substr(8);
-        }
-        else
-        {
-            Log::get() << "Error: bad protocol: " << location << std::endl;
-            onConnect(false, 400);
-            return;
-        }
-    
-        std::stringstream path;
-        path << ws << "?";
-        bool second = false;
+        m_location = location;
+        m_options = options;
+        m_extraHeaders = extraHeaders;
+        m_onConnect = onConnect;
+        m_onDisconnect = onDisconnect;
+        m_closing = false;
+        m_reconnectAttempt = 0;
+        m_reconnectPending = false;
+        m_resumeToken.clear();
         
-        for (Options::const_iterator it = options.begin(); it != options.end(); it++)
+        m_group->onConnection([=](uWS::WebSocket<uWS::CLIENT> *socket, uWS::HttpRequest request)
         {
-            if (second)
-            {
-                path << "&";
-            }
-            else
+            m_socket = socket;
+            m_connected = true;
+            
+            m_pingOutstanding = false;
+            m_latency.missedPongs = 0;
+            m_nextPingAt = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<float>(m_keepalivePolicy.interval));
+            
+            if (m_reconnectAttempt > 0)
             {
-                second = true;
+                Log::get() << "Websocket reconnected after " << m_reconnectAttempt << " attempt(s)" << std::endl;
+                
+                m_reconnectAttempt = 0;
+                replayResponseHandlers();
+                
+                if (m_onReconnected)
+                    m_onReconnected();
+                
+                return;
             }
             
-            path << url_encode(it->first) << "=" << url_encode(it->second);
-        }
-        
-        m_client.getDefaultGroup<uWS::CLIENT>().onConnection([=](uWS::WebSocket<uWS::CLIENT> *socket, uWS::HttpRequest request)
-        {
-            m_socket = socket;
-            m_connected = true;
-            onConnect(true, 200);
+            m_onConnect(true, 200);
         });
         
-        m_client.onDisconnection([=](uWS::WebSocket<uWS::CLIENT> *socket, int code, char * message, size_t length)
+        m_group->onDisconnection([=](uWS::WebSocket<uWS::CLIENT> *socket, int code, char * message, size_t length)
         {
+            m_open = false;
             m_connected = false;
+            m_socket = nullptr;
             
-            rejectAllResponseHandlers(code, "Disconnected", "Rejected, because websocet has been disconnected");
-            
-            // uWebSockets always returns 'message' as nullptr
-            onDisconnect(code, "Disconnected");
-            Log::get() << "Websocket disconnected: " << code << std::endl;
+            if (scheduleReconnect(code))
+            {
+                // calls that are safe to send again are kept until the socket is back
+                rejectNonReplayableResponseHandlers(code, "Disconnected", "Rejected, because websocet has been disconnected");
+                Log::get() << "Websocket disconnected: " << code << ", reconnecting" << std::endl;
+            }
+            else
+            {
+                rejectAllResponseHandlers(code, "Disconnected", "Rejected, because websocet has been disconnected");
+                
+                // uWebSockets always returns 'message' as nullptr
+                m_onDisconnect(code, "Disconnected");
+                Log::get() << "Websocket disconnected: " << code << std::endl;
+            }
 
 			if( socket )
 			{
@@ -135,8 +258,8 @@ namespace online
 							}
 						}
 
-						Log::get() << "Socket Node Data" << std::endl;
-						Log::get() << "Data(" << nodeData.size() << "): " << nodeData << std::endl << std::endl;
+						OnlineLog(LEVEL_DEBUG) << "Socket Node Data" << std::endl;
+						OnlineLog(LEVEL_DEBUG) << "Data(" << nodeData.size() << "): " << nodeData << std::endl << std::endl;
 
 						if( AnthillRuntime::IsInstanceValid() )
 						{
@@ -156,22 +279,132 @@ namespace online
 			}
         });
         
-        m_client.onError([this, onConnect](void *user)
+        m_group->onError([this](void *user)
         {
+            m_open = false;
             m_connected = false;
             
-            Log::get() << m_client.getDefaultGroup<uWS::CLIENT>().getCloseMessage() << " "
-            << m_client.getDefaultGroup<uWS::CLIENT>().getCloseContents() << std::endl;
-            onConnect(false, m_client.getDefaultGroup<uWS::CLIENT>().getCloseCode());
+            Log::get() << m_group->getCloseMessage() << " "
+            << m_group->getCloseContents() << std::endl;
+            
+            if (m_reconnectAttempt > 0)
+            {
+                // a failed reconnect attempt counts as an abnormal closure
+                if (!scheduleReconnect(1006))
+                {
+                    rejectAllResponseHandlers(599, "Disconnected", "Failed to reconnect");
+                    m_onDisconnect(1006, "Disconnected");
+                }
+                
+                return;
+            }
+            
+            m_onConnect(false, m_group->getCloseCode());
         });
         
-        m_client.connect(path.str(), nullptr, extraHeaders);
+        if (!open(location, options))
+        {
+            onConnect(false, 400);
+        }
+    }
+    
+    bool WebsocketRPC::open(const std::string& location, const Options& options)
+    {
+        std::string ws;
+        
+        if (location.find("http://") == 0)
+        {
+            ws = "ws://" + location.substr(7);
+        }
+        else if (location.find("https://") == 0)
+        {
+            ws = "wss://" + location.substr(8);
+        }
+        else
+        {
+            Log::get() << "Error: bad protocol: " << location << std::endl;
+            return false;
+        }
+    
+        std::stringstream path;
+        path << ws << "?";
+        bool second = false;
+        
+        for (Options::const_iterator it = options.begin(); it != options.end(); it++)
+        {
+            if (second)
+            {
+                path << "&";
+            }
+            else
+            {
+                second = true;
+            }
+            
+            path << url_encode(it->first) << "=" << url_encode(it->second);
+        }
+        
+        m_open = true;
+        m_hub->connect(path.str(), m_extraHeaders, m_group);
+        return true;
+    }
+    
+    bool WebsocketRPC::scheduleReconnect(int code)
+    {
+        if (!m_reconnectPolicy.enabled || m_closing)
+            return false;
+        
+        if (code == 1000 || code >= 3000)
+            return false;
+        
+        if (m_reconnectAttempt >= m_reconnectPolicy.maxAttempts)
+        {
+            m_reconnectAttempt = 0;
+            return false;
+        }
+        
+        float delay = std::min(
+            m_reconnectPolicy.initialDelay * std::pow(m_reconnectPolicy.multiplier, (float)m_reconnectAttempt),
+            m_reconnectPolicy.maxDelay);
+        
+        std::uniform_real_distribution<float> spread(1.0f - m_reconnectPolicy.jitter, 1.0f);
+        delay *= spread(m_random);
+        
+        m_reconnectAttempt++;
+        m_reconnectPending = true;
+        m_reconnectAt = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(delay));
+        
+        if (m_onReconnecting)
+            m_onReconnecting(m_reconnectAttempt, delay);
+        
+        return true;
+    }
+    
+    void WebsocketRPC::setReconnectCallbacks(ReconnectingCallback onReconnecting, ReconnectedCallback onReconnected)
+    {
+        m_onReconnecting = onReconnecting;
+        m_onReconnected = onReconnected;
+    }
+    
+    void WebsocketRPC::setReconnectLocation(const std::string& location, const Options& options)
+    {
+        m_location = location;
+        m_options = options;
     }
     
     void WebsocketRPC::disconnect(int code, const std::string& reason)
     {
-        m_client.getDefaultGroup<uWS::CLIENT>().close(code, (char*)reason.c_str(), reason.size());
-        m_client.getDefaultGroup<uWS::CLIENT>().terminate();
+        m_closing = true;
+        
+        if (m_reconnectPending)
+        {
+            m_reconnectPending = false;
+            m_reconnectAttempt = 0;
+            rejectAllResponseHandlers(code, "Disconnected", reason);
+        }
+        
+        m_group->close(code, (char*)reason.c_str(), reason.size());
+        m_group->terminate();
 
 		m_connected = false;
     }
@@ -182,13 +415,93 @@ namespace online
         received(data);
     }
     
+    void WebsocketRPC::onPong(uWS::WebSocket<uWS::CLIENT> *ws, char *message, size_t length)
+    {
+        if (!m_pingOutstanding || std::string(message, length) != std::to_string(m_pingId))
+            return;
+        
+        m_pingOutstanding = false;
+        m_latency.missedPongs = 0;
+        
+        float rtt = std::chrono::duration<float>(Clock::now() - m_pingSentAt).count();
+        
+        if (m_latency.samples == 0)
+        {
+            m_latency.rtt = rtt;
+            m_latency.jitter = rtt / 2.0f;
+        }
+        else
+        {
+            m_latency.jitter = 0.75f * m_latency.jitter + 0.25f * std::fabs(m_latency.rtt - rtt);
+            m_latency.rtt = 0.875f * m_latency.rtt + 0.125f * rtt;
+        }
+        
+        m_latency.lastRtt = rtt;
+        m_latency.samples++;
+    }
+    
+    void WebsocketRPC::keepalive()
+    {
+        if (!m_keepalivePolicy.enabled || !m_connected || !m_socket)
+            return;
+        
+        Clock::time_point now = Clock::now();
+        
+        if (now < m_nextPingAt)
+            return;
+        
+        m_nextPingAt = now + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<float>(m_keepalivePolicy.interval));
+        
+        if (m_pingOutstanding)
+        {
+            m_latency.missedPongs++;
+            
+            if (m_latency.missedPongs >= m_keepalivePolicy.maxMissedPongs)
+            {
+                Log::get() << "Websocket peer missed " << m_latency.missedPongs << " pongs, dropping the connection" << std::endl;
+                
+                // reported as an abnormal closure, so the reconnect policy applies
+                m_socket->terminate();
+                return;
+            }
+        }
+        
+        m_pingId++;
+        m_pingOutstanding = true;
+        m_pingSentAt = now;
+        m_socket->ping(std::to_string(m_pingId).c_str());
+    }
+    
     void WebsocketRPC::update()
     {
-        uv_loop_t* loop = (uv_loop_t*)m_client.getLoop();
-		if (loop)
-		{
-			uv_run(loop, UV_RUN_NOWAIT);
-		}
+        // a shared loop is run by the runtime once per update for every connection
+        if (m_ownsHub)
+        {
+            m_hub->update();
+        }
+        
+        if (m_reconnectPending && Clock::now() >= m_reconnectAt)
+        {
+            m_reconnectPending = false;
+            
+            Options options = m_options;
+            
+            if (!m_resumeToken.empty())
+            {
+                options["resume_token"] = m_resumeToken;
+            }
+            
+            if (!open(m_location, options))
+            {
+                m_reconnectAttempt = 0;
+                rejectAllResponseHandlers(400, "Disconnected", "Failed to reconnect");
+                m_onDisconnect(400, "Disconnected");
+            }
+        }
+        
+        keepalive();
+        JsonRPC::update();
     }
 
     bool WebsocketRPC::read(std::string& data)
@@ -198,6 +511,12 @@ namespace online
     
     void WebsocketRPC::write(const std::string& data)
     {
+        if (!m_connected || !m_socket)
+        {
+            Log::get() << "Websocket is not connected, dropping a message" << std::endl;
+            return;
+        }
+        
         m_socket->send(data.c_str(), data.size(), uWS::OpCode::BINARY);
     }
     
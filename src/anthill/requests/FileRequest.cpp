@@ -60,12 +60,13 @@ namespace online
 		m_onProgress = onProgress;
 	}
 
-	void FileRequest::done()
+	void FileRequest::complete()
 	{
-		Request::done();
+		Request::complete();
 
 		if (m_onResponse)
 		{
+			Tracer::Scope scope(getSpan());
 			m_onResponse(*this);
 		}
 	}
@@ -36,9 +36,17 @@ namespace online
 		m_onResponse = onResponse;
 	}
 
-	void JsonRequest::done()
+	bool JsonRequest::rewind()
 	{
-		Request::done();
+		m_responseValueValid = false;
+		m_responseValue = Json::Value();
+
+		return StringStreamRequest::rewind();
+	}
+
+	void JsonRequest::complete()
+	{
+		Request::complete();
 
 		if (m_parseAsJsonAnyway || getResponseContentType() == "application/json")
 		{
@@ -47,6 +55,7 @@ namespace online
 
 		if (m_onResponse)
 		{
+			Tracer::Scope scope(getSpan());
 			m_onResponse(*this);
 		}
 	}
@@ -1,5 +1,6 @@
 
 #include "anthill/AnthillRuntime.h"
+#include "anthill/TokenManager.h"
 
 #include "anthill/requests/Request.h"
 #include "anthill/Utils.h"
@@ -71,6 +72,8 @@ namespace online
 	{
 		OnlineAssert(m_status == NONE, "Request is already started.");
 
+		m_url = m_location;
+
 		if (!m_arguments.empty())
 		{
 			std::set<std::string> pairs;
@@ -82,10 +85,11 @@ namespace online
 				pairs.insert(it->first + "=" + value);
 			}
 
-			m_location += "?" + join(pairs, "&");
+			m_url += "?" + join(pairs, "&");
 		}
   
-        if (!m_APIVersion.empty())
+        // a replayed request has got its headers already
+        if (!m_APIVersion.empty() && !m_replayed)
         {
             m_headers.add("X-API-Version: " + m_APIVersion);
         }
@@ -94,12 +98,12 @@ namespace online
 		m_transport.add<CURLOPT_HEADERFUNCTION>(&curl_header_function);
 		m_transport.add<CURLOPT_HEADERDATA>(this);
 
-		m_transport.add<CURLOPT_URL>(m_location.c_str());
+		m_transport.add<CURLOPT_URL>(m_url.c_str());
         m_transport.add<CURLOPT_FOLLOWLOCATION>(m_followRedirects ? 1L : 0L);
 
 		m_transport.add<CURLOPT_SSL_VERIFYPEER>( false );
 
-		m_transport.add<CURLOPT_TIMEOUT>( 60 * 2 );
+		m_transport.add<CURLOPT_TIMEOUT>( m_timeout );
 
 
 		switch (m_method)
@@ -177,6 +181,32 @@ namespace online
             }
 		}
 
+		Tracer& tracer = Tracer::get();
+
+		if (tracer.isEnabled())
+		{
+			Json::Value args;
+
+			// the query carries the access token (and whatever else is secret), so the traces only get
+			// the scheme, the host and the path, and the names of the arguments
+			args["url"] = m_location.substr(0, m_location.find('?'));
+			args["replay"] = m_replayed;
+
+			if (!m_arguments.empty())
+			{
+				Json::Value& names = args["arguments"] = Json::Value(Json::arrayValue);
+
+				for (Request::Fields::const_iterator it = m_arguments.begin(); it != m_arguments.end(); it++)
+				{
+					names.append(it->first);
+				}
+			}
+
+			m_span = tracer.begin("request", m_name ? m_name : "request", args);
+		}
+
+		m_started = std::chrono::steady_clock::now();
+
 		AnthillRuntime::Instance().addRequest(shared_from_this());
 
 		m_status = STARTED;
@@ -192,6 +222,11 @@ namespace online
         m_followRedirects = followRedirects;
     }
 
+    void Request::setTimeout(long timeout)
+    {
+        m_timeout = timeout;
+    }
+
 	void Request::done()
 	{
 		//long headersSize = m_transport.get_info<CURLINFO_HEADER_SIZE>().get();
@@ -207,6 +242,37 @@ namespace online
             connectionError();
         }
 
+        if (m_span)
+        {
+            Json::Value args;
+            args["result"] = (int)m_result;
+
+            Tracer::get().end(m_span, args);
+        }
+
+        // the access token might have expired, in which case the request is replayed with a fresh one
+        if ((m_result == UNAUTHORIZED || m_result == FORBIDDEN) && !m_replayed)
+        {
+            const TokenManagerPtr& tokenManager = AnthillRuntime::Instance().getTokenManager();
+
+            if (tokenManager && tokenManager->intercept(shared_from_this()))
+                return;
+        }
+
+        complete();
+	}
+
+	void Request::complete()
+	{
+		// whatever the callbacks start, follows from this request; the ones of the subclasses
+		// open the same scope around their own callbacks
+		Tracer::Scope scope(m_span);
+
+		if (AnthillRuntime::IsInstanceValid())
+		{
+			AnthillRuntime::Instance().requestCompleted(*this, getElapsed());
+		}
+
 		if (m_onResponse)
 		{
 			m_onResponse(*this);
@@ -214,6 +280,50 @@ namespace online
 
 		m_status = COMPLETED;
 	}
+
+	float Request::getElapsed() const
+	{
+		return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_started).count();
+	}
+
+	std::string Request::getAccessToken() const
+	{
+		Fields::const_iterator it = m_arguments.find("access_token");
+
+		if (it != m_arguments.end())
+			return it->second;
+
+		it = m_postFields.find("access_token");
+
+		if (it != m_postFields.end())
+			return it->second;
+
+		return "";
+	}
+
+	bool Request::replay(const std::string& accessToken)
+	{
+		if (m_replayed || m_cancelled || !rewind())
+			return false;
+
+		if (m_arguments.find("access_token") != m_arguments.end())
+		{
+			m_arguments["access_token"] = accessToken;
+		}
+
+		if (m_postFields.find("access_token") != m_postFields.end())
+		{
+			m_postFields["access_token"] = accessToken;
+		}
+
+		m_replayed = true;
+		m_responseHeaders.clear();
+		m_result = NOT_INITIALIZED;
+		m_status = NONE;
+
+		start();
+		return true;
+	}
 	
 	void Request::setOnResponse(Request::ResponseCallback onResponse)
 	{
@@ -311,7 +421,14 @@ namespace online
 
 	Request::~Request()
 	{
-		//
+		// never completed, e.g. cancelled or shut down in the middle
+		if (m_span)
+		{
+			Json::Value args;
+			args["abandoned"] = true;
+
+			Tracer::get().end(m_span, args);
+		}
 	}
 
 	bool Request::init()
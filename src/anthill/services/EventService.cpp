@@ -13,13 +13,19 @@ namespace online
     const std::string EventService::API_VERSION = "0.2";
 
     Event::Event(const Json::Value& data) :
+        Event(data, online::get_utc_timestamp())
+    {
+    }
+
+    Event::Event(const Json::Value& data, EventTime serverTime) :
 		m_enabled(false),
 		m_joined(false),
 		m_score(0),
 		m_timeStart((EventTime)0),
 		m_timeEnd((EventTime)0),
 		m_timeLeft(0),
-		m_timeLeftNow((EventTime)0),
+		m_serverTime(serverTime),
+		m_receivedAt(std::chrono::steady_clock::now()),
 		m_tournament(false)
     {
         m_id = data["id"].asString();
@@ -68,7 +74,6 @@ namespace online
             if (time.isMember("left"))
             {
                 m_timeLeft = time["left"].asInt();
-                m_timeLeftNow = online::get_utc_timestamp();
             }
         }
         
@@ -107,12 +112,18 @@ namespace online
         m_data = data;
     }
     
+    Event::EventTime Event::getServerTime() const
+    {
+        return m_serverTime + (EventTime)std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - m_receivedAt).count();
+    }
+
     bool Event::isActive() const
     {
         if (!m_enabled)
             return false;
         
-        EventTime now = online::get_utc_timestamp();
+        EventTime now = getServerTime();
         
         if (now < m_timeStart)
             return false;
@@ -125,8 +136,8 @@ namespace online
     
     int Event::getTimeLeftSeconds() const
     {
-        EventTime now = online::get_utc_timestamp();
-        int passed = now - m_timeLeftNow;
+        int passed = (int)std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - m_receivedAt).count();
         int left = m_timeLeft - passed;
         if (left > 0)
             return left;
@@ -176,6 +187,14 @@ namespace online
 				if (request.isSuccessful() && request.isResponseValueValid())
 				{
 					const Json::Value& value = request.getResponseValue();
+
+                    // once for all of the events, by the clock of the server if it has said what it is
+                    Event::EventTime serverTime = online::parse_http_date(request.getResponseHeader("Date"));
+
+                    if (serverTime == 0)
+                    {
+                        serverTime = online::get_utc_timestamp();
+                    }
      
                     if (value.isMember("events"))
                     {
@@ -185,7 +204,7 @@ namespace online
                         {
 							std::string id = (*it)["id"].asString();
        
-                            events[id] = std::make_shared<Event>(*it);
+                            events[id] = std::make_shared<Event>(*it, serverTime);
                         }
                     }
                     
@@ -51,6 +51,31 @@ namespace online
         return m_sockets->isConnected();
     }
     
+    void ExecSession::setReconnectPolicy(const WebsocketRPC::ReconnectPolicy& policy)
+    {
+        m_sockets->setReconnectPolicy(policy);
+    }
+    
+    void ExecSession::beginBatch()
+    {
+        m_sockets->beginBatch();
+    }
+    
+    void ExecSession::flush()
+    {
+        m_sockets->flush();
+    }
+    
+    void ExecSession::setKeepalivePolicy(const WebsocketRPC::KeepalivePolicy& policy)
+    {
+        m_sockets->setKeepalivePolicy(policy);
+    }
+    
+    const WebsocketRPC::LatencyStats& ExecSession::getLatencyStats() const
+    {
+        return m_sockets->getLatencyStats();
+    }
+    
     void ExecSession::connect(const std::string& accessToken, const std::string& className, const Json::Value& args,
         ExecSession::SessionCreatedCallback onCreated, ExecSession::SessionClosedCallback onClosed)
     {
@@ -120,6 +120,17 @@ namespace online
 			const Json::Value& partyValue = partyInfo["party"];
    
             Party party(partyValue);
+            
+            // the party is known now, so a dropped session comes back to it
+            // instead of creating or finding another one
+            if (!party.getId().empty())
+            {
+                m_sockets->setReconnectLocation(m_location + "/party/" + party.getId() + "/session", {
+                    {"access_token", m_accessToken},
+                    {"auto_join", "false"},
+                    {"reunion", "true"}
+                });
+            }
 
 			const Json::Value& partyMembers = partyInfo["members"];
 			std::list<PartyMember> partyMembersList;
@@ -316,6 +327,31 @@ namespace online
         return m_sockets->isConnected();
     }
     
+    void PartySession::setReconnectPolicy(const WebsocketRPC::ReconnectPolicy& policy)
+    {
+        m_sockets->setReconnectPolicy(policy);
+    }
+    
+    void PartySession::beginBatch()
+    {
+        m_sockets->beginBatch();
+    }
+    
+    void PartySession::flush()
+    {
+        m_sockets->flush();
+    }
+    
+    void PartySession::setKeepalivePolicy(const WebsocketRPC::KeepalivePolicy& policy)
+    {
+        m_sockets->setKeepalivePolicy(policy);
+    }
+    
+    const WebsocketRPC::LatencyStats& PartySession::getLatencyStats() const
+    {
+        return m_sockets->getLatencyStats();
+    }
+    
     void PartySession::connect(
         const std::string& accessToken,
         const std::string& partyId,
@@ -326,6 +362,8 @@ namespace online
         const Json::Value& memberProfile,
         const Json::Value& checkMembers)
     {
+        m_accessToken = accessToken;
+        
         WebsocketRPC::Options options = {
             {"access_token", accessToken},
             {"auto_join", autoJoin ? "true" : "false"},
@@ -380,6 +418,8 @@ namespace online
         bool autoJoin,
         const Json::Value& memberProfile)
     {
+        m_accessToken = accessToken;
+        
         const ApplicationInfo& applicationInfo = AnthillRuntime::Instance().getApplicationInfo();
 
         WebsocketRPC::Options options = {
@@ -444,6 +484,8 @@ namespace online
             bool createAutoClose,
             const std::string& createCloseCallback)
     {
+        m_accessToken = accessToken;
+        
         const ApplicationInfo& applicationInfo = AnthillRuntime::Instance().getApplicationInfo();
 
         WebsocketRPC::Options options = {
@@ -42,7 +42,25 @@ namespace online
 
 	
     void LeaderboardService::getLeaderboardEntries(const std::string& name, const std::string& order,
-        const std::string& accessToken, GetLeaderboardEntriesCallback callback, int limit)
+        const std::string& accessToken, GetLeaderboardEntriesCallback callback, int limit, int offset)
+    {
+		getLeaderboardPage(name, order, offset, limit, false, accessToken,
+			[callback](const LeaderboardService& service, Request::Result result, const Request& request, const Json::Value& data)
+		{
+			LeaderboardEntries entries;
+
+			for (Json::ValueConstIterator it = data.begin(); it != data.end(); it++)
+			{
+				const Json::Value& entry = *it;
+				entries.push_back(std::make_shared<LeaderboardEntry>(entry));
+			}
+
+			callback(service, result, request, entries);
+		});
+	}
+
+    void LeaderboardService::getLeaderboardPage(const std::string& name, const std::string& order, int offset, int limit,
+		bool aroundMe, const std::string& accessToken, GetLeaderboardPageCallback callback)
     {
 		if( name.empty() )
 		{
@@ -63,36 +81,41 @@ namespace online
         {
 			request->setName("leaderboard_entries");
             request->setAPIVersion(API_VERSION);
-        
-            request->setRequestArguments({
+
+			Request::Fields arguments = {
                 { "access_token", accessToken },
                 { "limit", std::to_string( limit ) }
-            });
+            };
+
+			if (aroundMe)
+			{
+				arguments["arround_me"] = "true";
+			}
+			else if (offset > 0)
+			{
+				arguments["offset"] = std::to_string(offset);
+			}
+        
+            request->setRequestArguments(arguments);
             
             request->setOnResponse([callback, this](const online::JsonRequest& request)
             {
                 if (request.isSuccessful() && request.isResponseValueValid())
                 {
-					LeaderboardEntries entries;
-
 				    const Json::Value& value = request.getResponseValue();
                    
-                    if (value.isMember("data"))
+                    if (value.isMember("data") && value["data"].isArray())
                     {
-                        const Json::Value& data = value["data"];
-                        
-                        for (Json::ValueConstIterator it = data.begin(); it != data.end(); it++)
-                        {
-                            const Json::Value& entry = *it;
-							entries.push_back(std::make_shared<LeaderboardEntry>(entry));
-                        }
+                        callback(*this, request.getResult(), request, value["data"]);
                     }
-                   
-                    callback(*this, request.getResult(), request, entries);
+					else
+					{
+						callback(*this, request.getResult(), request, Json::Value(Json::arrayValue));
+					}
                 }
                 else
                 {
-				    callback(*this, request.getResult(), request, LeaderboardEntries());
+				    callback(*this, request.getResult(), request, Json::Value(Json::arrayValue));
                 }
             });
         }
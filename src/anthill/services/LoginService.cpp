@@ -830,6 +830,13 @@ namespace online
 		m_currentToken = token;
 	}
 
+	void LoginService::setCurrentAccount(const std::string& account, const std::string& credential, const Scopes& scopes)
+	{
+		m_currentAccount = account;
+		m_currentCredential = credential;
+		m_currentScopes = scopes;
+	}
+
 	LoginService::~LoginService()
 	{
 		//
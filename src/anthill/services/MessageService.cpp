@@ -19,6 +19,7 @@ namespace online
         m_sockets(WebsocketRPC::Create()),
         m_location(location)
     {
+        m_sockets->setIdempotent("mark_as_read");
     }
         
     bool MessageSession::isConnected() const
@@ -26,6 +27,21 @@ namespace online
         return m_sockets && m_sockets->isConnected();
     }
     
+    void MessageSession::setReconnectPolicy(const WebsocketRPC::ReconnectPolicy& policy)
+    {
+        m_sockets->setReconnectPolicy(policy);
+    }
+    
+    void MessageSession::setKeepalivePolicy(const WebsocketRPC::KeepalivePolicy& policy)
+    {
+        m_sockets->setKeepalivePolicy(policy);
+    }
+    
+    const WebsocketRPC::LatencyStats& MessageSession::getLatencyStats() const
+    {
+        return m_sockets->getLatencyStats();
+    }
+    
     void MessageSession::send(const std::string& recipientClass, const std::string& recipient, const std::string& messageType, const Json::Value& message, const std::set<std::string>& flags, MessageSession::MessageSendCallback callback)
     {
         if (!isConnected())
@@ -372,7 +388,7 @@ namespace online
                     std::map< std::string, std::uint32_t > results;
                     const Json::Value& response = request.getResponseValue();
 
-                    Log::get() << "NMRESP: " << response.toStyledString() << std::endl;
+                    OnlineLog(LEVEL_DEBUG) << "NMRESP: " << response.toStyledString() << std::endl;
 
                     const auto memberNames = response.getMemberNames();
                     for( const auto& memberName : memberNames )
@@ -496,7 +512,7 @@ namespace online
 				{
                     const Json::Value& response = request.getResponseValue();
 
-                    Log::get() << "DMRESP: " << response.toStyledString() << std::endl;
+                    OnlineLog(LEVEL_DEBUG) << "DMRESP: " << response.toStyledString() << std::endl;
                     callback( *this, request.getResult(), request );
 				}
 				else
@@ -539,7 +555,7 @@ namespace online
 				{
                     const Json::Value& response = request.getResponseValue();
 
-                    Log::get() << "BURESP: " << response.toStyledString() << std::endl;
+                    OnlineLog(LEVEL_DEBUG) << "BURESP: " << response.toStyledString() << std::endl;
                     callback( *this, request.getResult(), request );
 				}
 				else
@@ -579,7 +595,7 @@ namespace online
 				{
                     const Json::Value& response = request.getResponseValue();
 
-                    Log::get() << "BURESP: " << response.toStyledString() << std::endl;
+                    OnlineLog(LEVEL_DEBUG) << "BURESP: " << response.toStyledString() << std::endl;
                     callback( *this, request.getResult(), request );
 				}
 				else
@@ -28,6 +28,130 @@ namespace online
 	
     void ProfileService::getMassProfiles(const std::set<std::string>& accounts, const std::set<std::string>& profileFields, 
 		const std::string& accessToken, GetMassUserProfilesCallback callback)
+	{
+		if (!m_cache.isEnabled())
+		{
+			requestProfiles(accounts, profileFields, accessToken, callback);
+			return;
+		}
+
+		Profiles profiles;
+		std::set<std::string> missingAccounts;
+		std::set<std::string> missingFields;
+
+		for (const std::string& account: accounts)
+		{
+			checkMe(account, accessToken);
+
+			Json::Value& profile = profiles[account];
+			bool complete = true;
+
+			if (profileFields.empty())
+			{
+				complete = m_cache.get(account, "", profile);
+			}
+			else
+			{
+				profile = Json::Value(Json::objectValue);
+
+				for (const std::string& field: profileFields)
+				{
+					Json::Value value;
+
+					if (!m_cache.get(account, field, value))
+					{
+						complete = false;
+						missingFields.insert(field);
+					}
+					else if (!value.isNull())
+					{
+						profile[field] = value;
+					}
+				}
+			}
+
+			if (!complete)
+			{
+				missingAccounts.insert(account);
+			}
+		}
+
+		if (missingAccounts.empty())
+		{
+			AnthillRuntime::Instance().getFutures().postNextUpdate([this, profiles, callback]()
+			{
+				callback(*this, Request::SUCCESS, getCachedRequest(), profiles);
+			});
+
+			return;
+		}
+
+		// only the misses go to the server, merged into what's been cached already
+		requestProfiles(missingAccounts, profileFields.empty() ? profileFields : missingFields, accessToken,
+			[this, profiles, profileFields, missingAccounts, missingFields, callback](const ProfileService& service, Request::Result result,
+				const Request& request, const Profiles& received) mutable
+		{
+			if (!request.isSuccessful())
+			{
+				callback(*this, result, request, Profiles());
+				return;
+			}
+
+			for (Profiles::iterator entry = profiles.begin(); entry != profiles.end();)
+			{
+				Profiles::const_iterator it = received.find(entry->first);
+
+				if (profileFields.empty())
+				{
+					if (it != received.end())
+					{
+						entry->second = it->second;
+						m_cache.put(entry->first, "", it->second);
+					}
+					else if (missingAccounts.find(entry->first) != missingAccounts.end())
+					{
+						entry = profiles.erase(entry);
+						continue;
+					}
+
+					entry++;
+					continue;
+				}
+
+				// an account that is not there at all is not cached, it may be created later
+				if (it == received.end())
+				{
+					if (missingAccounts.find(entry->first) != missingAccounts.end())
+					{
+						entry = profiles.erase(entry);
+						continue;
+					}
+
+					entry++;
+					continue;
+				}
+
+				for (const std::string& field: missingFields)
+				{
+					const Json::Value& value = it->second[field];
+
+					if (!value.isNull())
+					{
+						entry->second[field] = value;
+					}
+
+					m_cache.put(entry->first, field, value);
+				}
+
+				entry++;
+			}
+
+			callback(*this, result, request, profiles);
+		});
+	}
+
+	void ProfileService::requestProfiles(const std::set<std::string>& accounts, const std::set<std::string>& profileFields,
+		const std::string& accessToken, GetMassUserProfilesCallback callback)
 	{
 		JsonRequestPtr request = JsonRequest::Create(getLocation() + "/profiles", Request::METHOD_GET);
         
@@ -144,6 +268,103 @@ namespace online
     
     void ProfileService::getProfile(const std::string& account, const std::string& path, const std::string& accessToken, GetProfileCallback callback)
     {
+		checkMe(account, accessToken);
+
+		Json::Value cached;
+
+		// the whole profile whatever the path is, same as the server answers
+		if (m_cache.get(account, "", cached))
+		{
+			AnthillRuntime::Instance().getFutures().postNextUpdate([this, cached, callback]()
+			{
+				callback(*this, Request::SUCCESS, getCachedRequest(), cached);
+			});
+
+			return;
+		}
+
+		// "me" is not known to the mass lookup
+		if (m_batchPolicy.enabled && account != "me")
+		{
+			batchProfile(account, accessToken, callback);
+			return;
+		}
+
+		requestProfile(account, path, accessToken, callback);
+	}
+
+	void ProfileService::batchProfile(const std::string& account, const std::string& accessToken, GetProfileCallback callback)
+	{
+		std::unordered_map<std::string, Batch>::iterator it = m_batches.find(accessToken);
+		bool scheduled = it != m_batches.end();
+
+		Batch& batch = scheduled ? it->second : m_batches[accessToken];
+
+		batch.accounts.insert(account);
+
+		BatchedLookup lookup = { account, callback };
+		batch.lookups.push_back(lookup);
+
+		if (batch.accounts.size() >= m_batchPolicy.maxAccounts)
+		{
+			flushBatch(accessToken);
+			return;
+		}
+
+		if (scheduled)
+			return;
+
+		Future::Callback flush = [this, accessToken]() { flushBatch(accessToken); };
+
+		if (m_batchPolicy.window > 0)
+		{
+			AnthillRuntime::Instance().getFutures().add(m_batchPolicy.window, flush);
+		}
+		else
+		{
+			AnthillRuntime::Instance().getFutures().postNextUpdate(flush);
+		}
+	}
+
+	void ProfileService::flushBatch(const std::string& accessToken)
+	{
+		std::unordered_map<std::string, Batch>::iterator it = m_batches.find(accessToken);
+
+		// sent already, once it was full
+		if (it == m_batches.end())
+			return;
+
+		Batch batch = std::move(it->second);
+		m_batches.erase(it);
+
+		std::vector<BatchedLookup> lookups = std::move(batch.lookups);
+
+		getMassProfiles(batch.accounts, std::set<std::string>(), accessToken,
+			[this, lookups](const ProfileService& service, Request::Result result, const Request& request, const Profiles& profiles)
+		{
+			for (const BatchedLookup& lookup: lookups)
+			{
+				if (!request.isSuccessful())
+				{
+					lookup.callback(*this, result, request, Json::Value());
+					continue;
+				}
+
+				Profiles::const_iterator profile = profiles.find(lookup.account);
+
+				if (profile == profiles.end())
+				{
+					lookup.callback(*this, Request::NOT_FOUND, request, Json::Value());
+					continue;
+				}
+
+				lookup.callback(*this, result, request, profile->second);
+			}
+		});
+	}
+
+	void ProfileService::requestProfile(const std::string& account, const std::string& path, const std::string& accessToken, GetProfileCallback callback)
+	{
         JsonRequestPtr request = JsonRequest::Create(getLocation() + "/profile/" + account, Request::METHOD_GET);
         
         if (request)
@@ -160,6 +381,9 @@ namespace online
                if (request.isSuccessful() && request.isResponseValueValid())
                {
 				   const Json::Value& value = request.getResponseValue();
+
+				   // the endpoint has no paths, it's always the whole profile
+				   m_cache.put(account, "", value);
                    
                    callback(*this, request.getResult(), request, value);
                }
@@ -180,6 +404,8 @@ namespace online
     void ProfileService::setProfile(const std::string& account, const std::string& path,
 		const Json::Value& profile, bool merge, const std::string& accessToken, SetProfileCallback callback)
     {
+		checkMe(account, accessToken);
+
         JsonRequestPtr request = JsonRequest::Create(getLocation() + "/profile/" + account, Request::METHOD_POST);
         
         if (request)
@@ -204,11 +430,16 @@ namespace online
                {
                    // get merged profile
 				   const Json::Value& value = request.getResponseValue();
+
+				   m_cache.put(account, "", value);
                    
                    callback(*this, request.getResult(), request, value);
                }
                else
                {
+				   // whatever the profile is now, it is not known for sure
+				   m_cache.invalidate(account);
+
 				   callback(*this, request.getResult(), request, Json::Value());
                }
             });
@@ -220,6 +451,27 @@ namespace online
         
         request->start();
     }
+
+	void ProfileService::checkMe(const std::string& account, const std::string& accessToken)
+	{
+		if (account != "me" || accessToken == m_myAccessToken)
+			return;
+
+		m_cache.invalidate("me");
+		m_myAccessToken = accessToken;
+	}
+
+	const Request& ProfileService::getCachedRequest()
+	{
+		if (!m_cachedRequest)
+		{
+			m_cachedRequest = JsonRequest::Create(getLocation() + "/profile", Request::METHOD_GET);
+			m_cachedRequest->setName("profile_cached");
+			m_cachedRequest->setResult(Request::SUCCESS);
+		}
+
+		return *m_cachedRequest;
+	}
     
     ProfileService::~ProfileService()
     {
@@ -4,6 +4,7 @@
 #include "anthill/AnthillRuntime.h"
 #include "anthill/Utils.h"
 
+#include <json/reader.h>
 #include <json/writer.h>
 
 namespace online
@@ -249,6 +250,128 @@ namespace online
         request->start();
     }
     
+    void StoreService::getCatalog(const std::string& name, const std::string& accessToken, GetCatalogCallback callback)
+    {
+        CachedCatalog& cached = m_catalogs[name];
+        const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+        const std::string key = Storage::StorageStoreCatalogField + name;
+
+        // the first time, from the last run
+        if (!cached.catalog && storage && storage->has(key))
+        {
+            Json::Value data;
+
+            if (Json::Reader().parse(storage->get(key), data, false))
+            {
+                cached.catalog = StoreCatalog::Create(name, data);
+
+                if (cached.catalog)
+                {
+                    cached.data = storage->get(key);
+                }
+            }
+        }
+
+        // what this call has handed out decides whether the response is to be reported,
+        // another call might fill the cache meanwhile
+        bool deliveredCached = (bool)cached.catalog;
+
+        if (deliveredCached)
+        {
+            StoreCatalogPtr catalog = cached.catalog;
+
+            AnthillRuntime::Instance().getFutures().postNextUpdate([this, catalog, callback]()
+            {
+                callback(*this, Request::SUCCESS, getCachedRequest(), catalog, true);
+            });
+        }
+
+        // refreshed in the background anyway
+        JsonRequestPtr request = JsonRequest::Create(
+            getLocation() + "/store/" + name, Request::METHOD_GET);
+
+        if (request)
+        {
+            request->setName("store_catalog");
+            request->setAPIVersion(API_VERSION);
+
+            request->setRequestArguments({
+                {"access_token", accessToken }
+            });
+
+            request->setOnResponse([=](const online::JsonRequest& request)
+            {
+                CachedCatalog& cached = m_catalogs[name];
+
+                if (!request.isSuccessful() || !request.isResponseValueValid())
+                {
+                    // whoever has got the cached one already can keep it
+                    if (!deliveredCached)
+                    {
+                        callback(*this, request.getResult(), request, StoreCatalogPtr(), false);
+                    }
+
+                    return;
+                }
+
+                std::string data = request.getResponseAsString();
+
+                // nothing has changed since
+                if (cached.catalog && cached.data == data)
+                {
+                    if (!deliveredCached)
+                    {
+                        callback(*this, request.getResult(), request, cached.catalog, false);
+                    }
+
+                    return;
+                }
+
+                StoreCatalogPtr catalog = StoreCatalog::Create(name, request.getResponseValue());
+
+                if (!catalog)
+                {
+                    callback(*this, Request::MISSING_RESPONSE_FIELDS, request, StoreCatalogPtr(), false);
+                    return;
+                }
+
+                cached.catalog = catalog;
+                cached.data = data;
+
+                if (AnthillRuntime::IsInstanceValid())
+                {
+                    const StoragePtr& storage = AnthillRuntime::Instance().getStorage();
+
+                    if (storage)
+                    {
+                        storage->set(Storage::StorageStoreCatalogField + name, data);
+                        storage->save();
+                    }
+                }
+
+                callback(*this, request.getResult(), request, catalog, false);
+            });
+        }
+        else
+        {
+            OnlineAssert(false, "Failed to construct a request.");
+        }
+
+        request->start();
+    }
+
+    const Request& StoreService::getCachedRequest()
+    {
+        if (!m_cachedRequest)
+        {
+            m_cachedRequest = JsonRequest::Create(getLocation() + "/store", Request::METHOD_GET);
+            m_cachedRequest->setName("store_cached");
+            m_cachedRequest->setResult(Request::SUCCESS);
+        }
+
+        return *m_cachedRequest;
+    }
+    
     StoreService::~StoreService()
     {
         //
@@ -39,6 +39,7 @@ namespace online
 
 				LoginServicePtr ptr = AnthillRuntime::Instance().get<LoginService>();
 				ptr->setCurrentAccessToken(accessToken);
+				ptr->setCurrentAccount(account, credential, scopes);
 
 				const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
 
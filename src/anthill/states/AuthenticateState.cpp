@@ -57,7 +57,7 @@ namespace online
 			OnlineAssert((bool)ptr, "Login service is not initialized!");
 
 			ptr->setCurrentAccessToken(accessToken);
-			
+			ptr->setCurrentAccount(account, credential, scopes);
 
 			const ListenerPtr& listener = online.getListener();
 
@@ -40,6 +40,7 @@ namespace online
 
 				LoginServicePtr ptr = AnthillRuntime::Instance().get<LoginService>();
 				ptr->setCurrentAccessToken(accessToken);
+				ptr->setCurrentAccount(account, credential, scopes);
 
 				const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
 
@@ -52,12 +52,23 @@ namespace online
 			m_currentState->release();
 		}
 
+		Tracer& tracer = Tracer::get();
+
+		tracer.end(m_stateSpan);
+		m_stateSpan = 0;
+
 		m_currentState = to;
 
 		if (m_currentState)
 		{
-			Log::get() << getName() << ": Switched to state '" << m_currentState->ID() << "'." << std::endl;
+			OnlineLog(LEVEL_DEBUG) << getName() << ": Switched to state '" << m_currentState->ID() << "'." << std::endl;
+
+			if (tracer.isEnabled())
+			{
+				m_stateSpan = tracer.begin("state", getName() + ": " + m_currentState->ID());
+			}
 
+			Tracer::Scope scope(m_stateSpan);
 			m_currentState->init();
 		}
         
@@ -86,11 +97,13 @@ namespace online
 	StateMachine::StateMachine(const std::string& name) :
 		m_currentState(nullptr),
 		m_name(name),
-        m_locked(false)
+        m_locked(false),
+        m_stateSpan(0)
 	{
 	}
 
 	StateMachine::~StateMachine()
 	{
+		Tracer::get().end(m_stateSpan);
 	}
 }
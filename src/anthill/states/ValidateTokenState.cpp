@@ -39,6 +39,8 @@ namespace online
                 {
                     Log::get() << "Access token is valid!" << std::endl;
 
+					AnthillRuntime::Instance().get<LoginService>()->setCurrentAccount(account, credential, scopes);
+
 					const ListenerPtr& listener = AnthillRuntime::Instance().getListener();
 
 					if (listener)
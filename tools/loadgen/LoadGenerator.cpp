@@ -0,0 +1,602 @@
+#include "LoadGenerator.h"
+#include "anthill/Log.h"
+#include "anthill/Utils.h"
+#include "anthill/Websockets.h"
+
+#include "anthill/services/DiscoveryService.h"
+#include "anthill/services/EnvironmentService.h"
+#include "anthill/services/LeaderboardService.h"
+#include "anthill/services/LoginService.h"
+#include "anthill/services/ProfileService.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+
+namespace online
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// the simulated players do not keep anything between the runs
+	class MemoryStorage : public Storage
+	{
+	public:
+		virtual void set(const std::string& key, const std::string& value) override { m_values[key] = value; }
+		virtual bool has(const std::string& key) const override { return m_values.find(key) != m_values.end(); }
+		virtual void remove(const std::string& key) override { m_values.erase(key); }
+		virtual void save() override {}
+
+		virtual std::string get(const std::string& key) const override
+		{
+			std::unordered_map<std::string, std::string>::const_iterator it = m_values.find(key);
+			return it != m_values.end() ? it->second : "";
+		}
+
+	private:
+		std::unordered_map<std::string, std::string> m_values;
+	};
+
+	static float percentile(const std::vector<float>& sorted, float p)
+	{
+		if (sorted.empty())
+			return 0;
+
+		size_t index = std::min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5f));
+		return sorted[index];
+	}
+
+	void LoadStats::add(const std::string& endpoint, float latency, bool success)
+	{
+		Endpoint& stats = m_endpoints[endpoint];
+
+		stats.calls++;
+		stats.latencies.push_back(latency);
+
+		if (!success)
+		{
+			stats.errors++;
+		}
+	}
+
+	void LoadStats::merge(const LoadStats& other)
+	{
+		for (const Endpoints::value_type& entry : other.m_endpoints)
+		{
+			Endpoint& stats = m_endpoints[entry.first];
+
+			stats.calls += entry.second.calls;
+			stats.errors += entry.second.errors;
+			stats.latencies.insert(stats.latencies.end(), entry.second.latencies.begin(), entry.second.latencies.end());
+		}
+	}
+
+	void LoadStats::clear()
+	{
+		m_endpoints.clear();
+	}
+
+	Json::Value LoadStats::dump(float elapsed) const
+	{
+		Json::Value result(Json::objectValue);
+
+		for (const Endpoints::value_type& entry : m_endpoints)
+		{
+			std::vector<float> sorted = entry.second.latencies;
+			std::sort(sorted.begin(), sorted.end());
+
+			Json::Value& endpoint = result[entry.first];
+
+			endpoint["calls"] = (Json::UInt64)entry.second.calls;
+			endpoint["errors"] = (Json::UInt64)entry.second.errors;
+			endpoint["throughput"] = elapsed > 0 ? entry.second.calls / elapsed : 0;
+			endpoint["p50"] = percentile(sorted, 0.5f);
+			endpoint["p90"] = percentile(sorted, 0.9f);
+			endpoint["p99"] = percentile(sorted, 0.99f);
+			endpoint["max"] = sorted.empty() ? 0 : sorted.back();
+		}
+
+		return result;
+	}
+
+	void LoadStats::report(std::ostream& out, float elapsed) const
+	{
+		out << std::left << std::setw(32) << "endpoint" << std::right
+			<< std::setw(10) << "calls" << std::setw(10) << "errors" << std::setw(8) << "err%"
+			<< std::setw(10) << "rps" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+			<< std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << "\n";
+
+		out << std::fixed << std::setprecision(1);
+
+		for (const Endpoints::value_type& entry : m_endpoints)
+		{
+			const Endpoint& stats = entry.second;
+
+			std::vector<float> sorted = stats.latencies;
+			std::sort(sorted.begin(), sorted.end());
+
+			out << std::left << std::setw(32) << entry.first << std::right
+				<< std::setw(10) << stats.calls
+				<< std::setw(10) << stats.errors
+				<< std::setw(8) << (stats.calls ? 100.0f * stats.errors / stats.calls : 0.0f)
+				<< std::setw(10) << (elapsed > 0 ? stats.calls / elapsed : 0.0f)
+				<< std::setw(10) << percentile(sorted, 0.5f) * 1000.0f
+				<< std::setw(10) << percentile(sorted, 0.9f) * 1000.0f
+				<< std::setw(10) << percentile(sorted, 0.99f) * 1000.0f
+				<< std::setw(10) << (sorted.empty() ? 0.0f : sorted.back()) * 1000.0f << "\n";
+		}
+	}
+
+	LoadScenario::LoadScenario() :
+		m_repeat(1),
+		m_continueOnError(false)
+	{
+		//
+	}
+
+	LoadScenario& LoadScenario::step(const std::string& name, Step step)
+	{
+		Entry entry = { name, step, true };
+		m_steps.push_back(entry);
+		return *this;
+	}
+
+	LoadScenario& LoadScenario::wait(float seconds)
+	{
+		Entry entry = { "wait", [seconds](SimulatedPlayer& player, StepDone done)
+		{
+			player.getRuntime()->getFutures().add(seconds, [done]() { done(true); });
+		}, false };
+
+		m_steps.push_back(entry);
+		return *this;
+	}
+
+	LoadScenario& LoadScenario::repeat(int times)
+	{
+		m_repeat = std::max(times, 1);
+		return *this;
+	}
+
+	LoadScenario& LoadScenario::continueOnError(bool value)
+	{
+		m_continueOnError = value;
+		return *this;
+	}
+
+	LoadScenario::Step LoadScenario::authenticate()
+	{
+		return [](SimulatedPlayer& player, StepDone done)
+		{
+			LoginServicePtr login = player.getRuntime()->get<LoginService>();
+
+			if (!login)
+			{
+				done(false);
+				return;
+			}
+
+			const ApplicationInfo& info = player.getRuntime()->getApplicationInfo();
+
+			player.username = "loadgen-" + random_string(16);
+
+			login->authenticateAnonymous(player.username, random_string(32), info.gamespace, info.requiredScopes, Request::Fields(),
+				[&player, login, done](const LoginService& service, Request::Result result, const Request& request,
+					const std::string& accessToken, const std::string& credential, const std::string& account, const LoginService::Scopes& scopes)
+			{
+				if (!request.isSuccessful())
+				{
+					done(false);
+					return;
+				}
+
+				player.accessToken = accessToken;
+				player.account = account;
+				login->setCurrentAccessToken(accessToken);
+
+				done(true);
+			},
+				[done](const LoginService& service, const LoginService::MergeOptions options, LoginService::MergeResolveCallback resolve)
+			{
+				// a brand new account has nothing to merge with
+				done(false);
+			}, info.shouldHaveScopes);
+		};
+	}
+
+	LoadScenario::Step LoadScenario::getProfile(const std::string& path)
+	{
+		return [path](SimulatedPlayer& player, StepDone done)
+		{
+			ProfileServicePtr profiles = player.getRuntime()->get<ProfileService>();
+
+			if (!profiles)
+			{
+				done(false);
+				return;
+			}
+
+			profiles->getMyProfile(path, player.accessToken, [done](const ProfileService& service, Request::Result result,
+				const Request& request, const Json::Value& profile)
+			{
+				done(request.isSuccessful());
+			});
+		};
+	}
+
+	LoadScenario::Step LoadScenario::listenMessages()
+	{
+		return [](SimulatedPlayer& player, StepDone done)
+		{
+			MessageServicePtr messages = player.getRuntime()->get<MessageService>();
+
+			if (!messages)
+			{
+				done(false);
+				return;
+			}
+
+			player.messages = messages->session();
+
+			player.messages->listen(player.accessToken, [done](bool success, const std::string& reason)
+			{
+				done(success);
+			}, [done](int code, const std::string& reason)
+			{
+				done(false);
+			}, [](const std::string& uuid, const std::string& sender, const std::string& recipientClass,
+				const std::string& recipient, const std::string& messageType, const Json::Value& message,
+				const std::string& time, const MessageSession::MessageFlags& flags)
+			{
+				return true;
+			});
+		};
+	}
+
+	LoadScenario::Step LoadScenario::joinParty(const std::string& gameServerName)
+	{
+		return [gameServerName](SimulatedPlayer& player, StepDone done)
+		{
+			GameServicePtr game = player.getRuntime()->get<GameService>();
+
+			if (!game)
+			{
+				done(false);
+				return;
+			}
+
+			player.party = game->session(std::make_shared<PartySession::Listener>());
+
+			player.party->findPartyAndConnect(player.accessToken, gameServerName,
+				[done](const PartySession& session, Request::Result result)
+			{
+				done(Request::isSuccessful(result));
+			}, [done](int code, const std::string& reason)
+			{
+				done(false);
+			});
+		};
+	}
+
+	LoadScenario::Step LoadScenario::postScore(const std::string& leaderboard, const std::string& order)
+	{
+		return [leaderboard, order](SimulatedPlayer& player, StepDone done)
+		{
+			LeaderboardServicePtr leaderboards = player.getRuntime()->get<LeaderboardService>();
+
+			if (!leaderboards)
+			{
+				done(false);
+				return;
+			}
+
+			leaderboards->addLeaderboardEntry(leaderboard, order, (float)std::uniform_int_distribution<int>(0, 99999)(random_engine()), player.username, 86400,
+				player.accessToken, [done](const LeaderboardService& service, Request::Result result, const Request& request)
+			{
+				done(request.isSuccessful());
+			});
+		};
+	}
+
+	SimulatedPlayer::SimulatedPlayer(int index, const AnthillRuntimePtr& runtime, const LoadScenario& scenario) :
+		m_index(index),
+		m_runtime(runtime),
+		m_scenario(scenario),
+		m_step(0),
+		m_iteration(0),
+		m_started(false),
+		m_running(false),
+		m_failed(false)
+	{
+		//
+	}
+
+	void SimulatedPlayer::start()
+	{
+		m_started = true;
+		m_running = true;
+
+		AnthillRuntime::Scope scope(*m_runtime);
+		next();
+	}
+
+	void SimulatedPlayer::update(float dt)
+	{
+		m_runtime->update(dt);
+
+		AnthillRuntime::Scope scope(*m_runtime);
+
+		if (messages)
+		{
+			messages->update();
+		}
+
+		if (party)
+		{
+			party->update();
+		}
+	}
+
+	void SimulatedPlayer::next()
+	{
+		if (!m_running)
+			return;
+
+		if (m_step >= m_scenario.m_steps.size())
+		{
+			m_step = 0;
+
+			if (++m_iteration >= m_scenario.m_repeat)
+			{
+				m_running = false;
+				return;
+			}
+		}
+
+		const LoadScenario::Entry& entry = m_scenario.m_steps[m_step];
+
+		std::string name = "step:" + entry.name;
+		bool measured = entry.measured;
+		Clock::time_point started = Clock::now();
+		std::shared_ptr<bool> called = std::make_shared<bool>(false);
+
+		entry.step(*this, [this, name, measured, started, called](bool success)
+		{
+			// a step may report both a failure and a disconnect, only the first one counts
+			if (*called || !m_running)
+				return;
+
+			*called = true;
+
+			if (measured)
+			{
+				m_stats.add(name, std::chrono::duration<float>(Clock::now() - started).count(), success);
+			}
+
+			if (!success && !m_scenario.m_continueOnError)
+			{
+				m_failed = true;
+				m_running = false;
+				return;
+			}
+
+			m_step++;
+
+			// not from inside of the callback of the previous step
+			m_runtime->getFutures().postNextUpdate([this]() { next(); });
+		});
+	}
+
+	LoadGeneratorPtr LoadGenerator::Create(const Options& options, const LoadScenario& scenario)
+	{
+		LoadGeneratorPtr _object(new LoadGenerator(options, scenario));
+		if (!_object->init())
+			return LoadGeneratorPtr(nullptr);
+
+		return _object;
+	}
+
+	LoadGenerator::LoadGenerator(const Options& options, const LoadScenario& scenario) :
+		m_options(options),
+		m_scenario(scenario),
+		m_stopping(false),
+		m_finished(0),
+		m_failed(0),
+		m_elapsed(0)
+	{
+		//
+	}
+
+	bool LoadGenerator::init()
+	{
+		if (m_scenario.empty() || m_options.players <= 0 || m_options.environment.empty())
+			return false;
+
+		if (m_options.workers <= 0)
+		{
+			m_options.workers = std::max((int)std::thread::hardware_concurrency(), 1);
+		}
+
+		m_options.workers = std::min(m_options.workers, m_options.players);
+		return true;
+	}
+
+	bool LoadGenerator::discover()
+	{
+		AnthillRuntimePtr runtime = AnthillRuntime::Create(m_options.environment, m_options.services,
+			std::make_shared<MemoryStorage>(), nullptr, m_options.applicationInfo);
+
+		bool done = false;
+		bool success = false;
+
+		runtime->get<EnvironmentService>()->getEnvironmentInfo([&](const EnvironmentService& env, Request::Result result,
+			const Request& request, const std::string& discoveryLocation, const EnvironmentInformation& data)
+		{
+			if (!request.isSuccessful())
+			{
+				Log::get() << "Load generator: failed to get the environment: " << result << std::endl;
+				done = true;
+				return;
+			}
+
+			AnthillRuntime::Instance().get<EnvironmentService>()->setDiscoveryLocation(discoveryLocation);
+
+			AnthillRuntime::Instance().get<DiscoveryService>()->discoverServices(m_options.services,
+				[&](const DiscoveryService&, Request::Result result, const Request& request, const DiscoveredServices& services)
+			{
+				done = true;
+
+				if (!request.isSuccessful())
+				{
+					Log::get() << "Load generator: failed to discover the services: " << result << std::endl;
+					return;
+				}
+
+				for (DiscoveredServices::const_iterator it = services.begin(); it != services.end(); it++)
+				{
+					m_locations[it->first] = it->second->getLocation();
+				}
+
+				success = true;
+			});
+		});
+
+		while (!done && !m_stopping)
+		{
+			runtime->update(0);
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+
+		return success;
+	}
+
+	bool LoadGenerator::run()
+	{
+		if (!discover())
+			return false;
+
+		Log::get() << "Load generator: " << m_options.players << " players on " << m_options.workers << " workers" << std::endl;
+
+		Clock::time_point started = Clock::now();
+
+		std::vector<std::thread> workers;
+
+		for (int i = 0; i < m_options.workers; i++)
+		{
+			workers.push_back(std::thread(&LoadGenerator::work, this, i, m_options.workers));
+		}
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		m_elapsed = std::chrono::duration<float>(Clock::now() - started).count();
+		return true;
+	}
+
+	void LoadGenerator::work(int worker, int workers)
+	{
+		// declared first, so it outlives the sessions of the players
+		WebsocketHubPtr hub = WebsocketHub::Create();
+		std::vector< std::unique_ptr<SimulatedPlayer> > players;
+
+		for (int index = worker; index < m_options.players; index += workers)
+		{
+			AnthillRuntimePtr runtime = AnthillRuntime::Create(m_options.environment, m_options.services,
+				std::make_shared<MemoryStorage>(), nullptr, m_options.applicationInfo);
+
+			runtime->setWebsocketHub(hub);
+
+			for (const std::unordered_map<std::string, std::string>::value_type& location : m_locations)
+			{
+				runtime->SetService(location.first, location.second);
+			}
+
+			SimulatedPlayer* player = new SimulatedPlayer(index, runtime, m_scenario);
+			players.push_back(std::unique_ptr<SimulatedPlayer>(player));
+
+			runtime->setRequestObserver([player](const Request& request, float duration)
+			{
+				player->m_stats.add(request.getName() ? request.getName() : "request", duration, request.isSuccessful());
+			});
+		}
+
+		Clock::time_point started = Clock::now();
+		Clock::time_point last = started;
+
+		while (!m_stopping)
+		{
+			Clock::time_point now = Clock::now();
+
+			float elapsed = std::chrono::duration<float>(now - started).count();
+			float dt = std::chrono::duration<float>(now - last).count();
+			last = now;
+
+			if (elapsed >= m_options.duration)
+				break;
+
+			bool running = false;
+
+			for (const std::unique_ptr<SimulatedPlayer>& player : players)
+			{
+				if (!player->m_started && elapsed >= m_options.rampUp * player->m_index / m_options.players)
+				{
+					player->start();
+				}
+			}
+
+			hub->update();
+
+			for (const std::unique_ptr<SimulatedPlayer>& player : players)
+			{
+				if (!player->m_started)
+				{
+					running = true;
+					continue;
+				}
+
+				player->update(dt);
+
+				if (player->m_running)
+				{
+					running = true;
+				}
+			}
+
+			if (!running)
+				break;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (const std::unique_ptr<SimulatedPlayer>& player : players)
+		{
+			m_stats.merge(player->m_stats);
+
+			if (player->m_failed)
+			{
+				m_failed++;
+			}
+			else if (player->m_started && !player->m_running)
+			{
+				m_finished++;
+			}
+		}
+	}
+
+	void LoadGenerator::report(std::ostream& out) const
+	{
+		out << "players: " << m_options.players << ", finished: " << m_finished << ", failed: " << m_failed
+			<< ", elapsed: " << m_elapsed << "s\n";
+
+		m_stats.report(out, m_elapsed);
+	}
+
+	LoadGenerator::~LoadGenerator()
+	{
+		//
+	}
+}
@@ -0,0 +1,222 @@
+
+#ifndef ONLINE_LoadGenerator_H
+#define ONLINE_LoadGenerator_H
+
+#include "anthill/AnthillRuntime.h"
+#include "anthill/services/GameService.h"
+#include "anthill/services/MessageService.h"
+
+#include <json/value.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace online
+{
+	typedef std::shared_ptr< class LoadGenerator > LoadGeneratorPtr;
+	typedef std::shared_ptr< class SimulatedPlayer > SimulatedPlayerPtr;
+
+	// Calls, errors and latencies per endpoint: a request name (e.g. "login_auth")
+	// or a scenario step (e.g. "step:party")
+	class LoadStats
+	{
+	public:
+		struct Endpoint
+		{
+			Endpoint() :
+				calls(0),
+				errors(0)
+			{}
+
+			size_t calls;
+			size_t errors;
+			// seconds
+			std::vector<float> latencies;
+		};
+
+		typedef std::map<std::string, Endpoint> Endpoints;
+
+	public:
+		void add(const std::string& endpoint, float latency, bool success);
+		void merge(const LoadStats& other);
+		void clear();
+
+		const Endpoints& getEndpoints() const { return m_endpoints; }
+
+		// 'elapsed' is the duration of the run, in seconds
+		Json::Value dump(float elapsed) const;
+		void report(std::ostream& out, float elapsed) const;
+
+	private:
+		Endpoints m_endpoints;
+	};
+
+	// One simulated client: a runtime of its own, and whatever its scenario keeps
+	class SimulatedPlayer
+	{
+		friend class LoadGenerator;
+
+	public:
+		int getIndex() const { return m_index; }
+		const AnthillRuntimePtr& getRuntime() const { return m_runtime; }
+		LoadStats& getStats() { return m_stats; }
+
+		// the steps keep what they need for the next ones here
+		std::string username;
+		std::string accessToken;
+		std::string account;
+		MessageSessionPtr messages;
+		PartySessionPtr party;
+		Json::Value state;
+
+	private:
+		SimulatedPlayer(int index, const AnthillRuntimePtr& runtime, const class LoadScenario& scenario);
+
+		void start();
+		void update(float dt);
+		void next();
+
+	private:
+		int m_index;
+		AnthillRuntimePtr m_runtime;
+		const class LoadScenario& m_scenario;
+		LoadStats m_stats;
+
+		size_t m_step;
+		int m_iteration;
+		bool m_started;
+		bool m_running;
+		bool m_failed;
+	};
+
+	// The steps every simulated player goes through, in order. A step calls 'done' once it's complete;
+	// the time it took is recorded as "step:<name>", along with every request it has made.
+	//
+	//     online::LoadScenario scenario;
+	//     scenario
+	//         .step("auth", online::LoadScenario::authenticate())
+	//         .step("profile", online::LoadScenario::getProfile())
+	//         .wait(1.0f)
+	//         .step("score", online::LoadScenario::postScore("season", "desc"))
+	//         .repeat(10);
+	class LoadScenario
+	{
+		friend class SimulatedPlayer;
+
+	public:
+		typedef std::function< void(bool success) > StepDone;
+		typedef std::function< void(SimulatedPlayer& player, StepDone done) > Step;
+
+	public:
+		LoadScenario();
+
+		LoadScenario& step(const std::string& name, Step step);
+		// a pause that is not measured
+		LoadScenario& wait(float seconds);
+		// goes through all the steps that many times
+		LoadScenario& repeat(int times);
+		// by default, a player stops at the first failed step
+		LoadScenario& continueOnError(bool value);
+
+		bool empty() const { return m_steps.empty(); }
+
+	public:
+		// an anonymous account with random credentials, sets the access token of the player
+		static Step authenticate();
+		static Step getProfile(const std::string& path = "");
+		// opens a message session and listens to it
+		static Step listenMessages();
+		// finds (or creates) a party for the game server and joins it
+		static Step joinParty(const std::string& gameServerName);
+		static Step postScore(const std::string& leaderboard, const std::string& order);
+
+	private:
+		struct Entry
+		{
+			std::string name;
+			Step step;
+			bool measured;
+		};
+
+		std::vector<Entry> m_steps;
+		int m_repeat;
+		bool m_continueOnError;
+	};
+
+	// Drives a number of simulated players, each with a runtime of its own and the real services,
+	// through a scenario. The players are split between the worker threads, the players of a worker
+	// share its websocket loop. The services are discovered once and shared by all of the players.
+	class LoadGenerator
+	{
+	public:
+		struct Options
+		{
+			Options() :
+				players(100),
+				workers(0),
+				rampUp(10.0f),
+				duration(60.0f)
+			{}
+
+			std::string environment;
+			ApplicationInfo applicationInfo;
+			std::set<std::string> services;
+
+			int players;
+			// the number of hardware threads if 0
+			int workers;
+			// seconds to start all the players in, evenly
+			float rampUp;
+			// seconds after which the players still running are stopped
+			float duration;
+		};
+
+	public:
+		static LoadGeneratorPtr Create(const Options& options, const LoadScenario& scenario);
+		virtual ~LoadGenerator();
+
+		// blocks until every player has gone through the scenario, or the duration is over
+		bool run();
+
+		// can be called from any thread to end the run early
+		void stop() { m_stopping = true; }
+
+		const LoadStats& getStats() const { return m_stats; }
+		float getElapsed() const { return m_elapsed; }
+
+		size_t getFinished() const { return m_finished; }
+		size_t getFailed() const { return m_failed; }
+
+		void report(std::ostream& out) const;
+
+	protected:
+		LoadGenerator(const Options& options, const LoadScenario& scenario);
+		bool init();
+
+	private:
+		bool discover();
+		void work(int worker, int workers);
+
+	private:
+		Options m_options;
+		LoadScenario m_scenario;
+		std::unordered_map<std::string, std::string> m_locations;
+
+		std::atomic<bool> m_stopping;
+		std::mutex m_mutex;
+		LoadStats m_stats;
+		size_t m_finished;
+		size_t m_failed;
+		float m_elapsed;
+	};
+};
+
+#endif
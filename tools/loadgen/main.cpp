@@ -0,0 +1,170 @@
+
+// A headless load generator: drives simulated players against a real environment
+// and prints the throughput and latency percentiles of every endpoint.
+//
+//     AnthillLoadGenerator --environment http://environment-dev.example.com --gamespace root
+//         --app game --version 1.0 --players 1000 --ramp-up 60 --duration 300
+//         --scenario auth,profile,messages,wait:5,score:season
+
+#include "LoadGenerator.h"
+#include "anthill/Log.h"
+
+#include "anthill/services/GameService.h"
+#include "anthill/services/LeaderboardService.h"
+#include "anthill/services/LoginService.h"
+#include "anthill/services/MessageService.h"
+#include "anthill/services/ProfileService.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+static online::LoadGeneratorPtr generator;
+
+static void interrupt(int)
+{
+	if (generator)
+	{
+		generator->stop();
+	}
+}
+
+static void usage()
+{
+	std::cerr <<
+		"usage: AnthillLoadGenerator --environment <url> --gamespace <name> --app <name> --version <version>\n"
+		"    [--players 100] [--workers 0] [--ramp-up 10] [--duration 60] [--repeat 1] [--continue-on-error]\n"
+		"    [--scenario auth,profile,messages,party:<server>,score:<leaderboard>,wait:<seconds>]" << std::endl;
+}
+
+static bool addStep(online::LoadScenario& scenario, std::set<std::string>& services, const std::string& step)
+{
+	std::string name = step, argument;
+
+	size_t colon = step.find(':');
+	if (colon != std::string::npos)
+	{
+		name = step.substr(0, colon);
+		argument = step.substr(colon + 1);
+	}
+
+	if (name == "auth")
+	{
+		scenario.step(name, online::LoadScenario::authenticate());
+		services.insert(online::LoginService::ID);
+	}
+	else if (name == "profile")
+	{
+		scenario.step(name, online::LoadScenario::getProfile(argument));
+		services.insert(online::ProfileService::ID);
+	}
+	else if (name == "messages")
+	{
+		scenario.step(name, online::LoadScenario::listenMessages());
+		services.insert(online::MessageService::ID);
+	}
+	else if (name == "party" && !argument.empty())
+	{
+		scenario.step(name, online::LoadScenario::joinParty(argument));
+		services.insert(online::GameService::ID);
+	}
+	else if (name == "score" && !argument.empty())
+	{
+		scenario.step(name, online::LoadScenario::postScore(argument, "desc"));
+		services.insert(online::LeaderboardService::ID);
+	}
+	else if (name == "wait" && !argument.empty())
+	{
+		scenario.wait((float)atof(argument.c_str()));
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	online::LoadGenerator::Options options;
+	online::LoadScenario scenario;
+
+	std::string steps = "auth,profile";
+	int repeat = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--continue-on-error")
+		{
+			scenario.continueOnError(true);
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			usage();
+			return 1;
+		}
+
+		std::string value = argv[++i];
+
+		if (arg == "--environment") options.environment = value;
+		else if (arg == "--gamespace") options.applicationInfo.gamespace = value;
+		else if (arg == "--app") options.applicationInfo.applicationName = value;
+		else if (arg == "--version") options.applicationInfo.applicationVersion = value;
+		else if (arg == "--players") options.players = atoi(value.c_str());
+		else if (arg == "--workers") options.workers = atoi(value.c_str());
+		else if (arg == "--ramp-up") options.rampUp = (float)atof(value.c_str());
+		else if (arg == "--duration") options.duration = (float)atof(value.c_str());
+		else if (arg == "--repeat") repeat = atoi(value.c_str());
+		else if (arg == "--scenario") steps = value;
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	// the steps go in the order they are listed
+	size_t start = 0;
+
+	while (start <= steps.size())
+	{
+		size_t end = steps.find(',', start);
+		if (end == std::string::npos)
+			end = steps.size();
+
+		std::string step = steps.substr(start, end - start);
+
+		if (!step.empty() && !addStep(scenario, options.services, step))
+		{
+			std::cerr << "unknown step: " << step << std::endl;
+			usage();
+			return 1;
+		}
+
+		start = end + 1;
+	}
+
+	scenario.repeat(repeat);
+
+	generator = online::LoadGenerator::Create(options, scenario);
+
+	if (!generator)
+	{
+		usage();
+		return 1;
+	}
+
+	signal(SIGINT, interrupt);
+
+	bool success = generator->run();
+
+	generator->report(std::cout);
+	online::Log::flush();
+
+	return success ? 0 : 1;
+}